@@ -0,0 +1,147 @@
+/*Project: Sudoku Creator
+  Description: Solve many puzzles on all cores.
+  Puzzles are read from the files given (or the standard input), each
+  file may hold many puzzles: SIZE lines of SIZE symbols separated by
+  blank lines, or one line of SIZE*SIZE symbols ('0' or '.' is empty).
+  Regular files are memory-mapped.
+  With --packed or --ranked, puzzles are binary records (sudoku_write()).
+  One line is written per puzzle, in input order:
+  <number> <solved|multiple|none|invalid> <solution or ->*/
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include"sudoku.h"
+
+/* Variables*/
+sudoku_ctx *ctx;
+sudoku_job *jobs;
+int n_jobs,max_jobs;
+
+/*Functions*/
+void read_jobs(FILE *fp);    /* add every puzzle of a stream to jobs*/
+void load_jobs(FILE *fp);    /* the same for binary records*/
+void add_job(int table[][SIZE]);
+void print_job(int i,FILE *fp);
+
+const char *status_name[]={"solved","multiple","none","invalid"};
+
+/****************MAIN************/
+int main(int argc, char **argv){
+  long long start,t;
+  int i;
+  FILE *fp;
+
+  start=sudoku_now();
+  ctx=sudoku_new();
+  /* Options come before the file names
+     -j N : use N threads (default: one per core)*/
+  for(i=1; i<argc && argv[i][0]=='-' && argv[i][1]; ++i){
+    if(!strcmp(argv[i],"-j") && i+1<argc)
+      ctx->n_threads=atoi(argv[++i]);
+    else if(!sudoku_option(ctx,argv[i])){
+      fprintf(stderr,"Unknown option %s\n",argv[i]);
+      exit(1);
+    }
+  }
+  /* Read puzzles*/
+  t=sudoku_now();
+  if(i==argc)
+    read_jobs(stdin);
+  for(; i<argc; ++i){
+    if(!strcmp(argv[i],"-"))
+      fp=stdin;
+    else if(ctx->format==FORMAT_TEXT && sudoku_map(argv[i],&jobs,&n_jobs,&max_jobs)>=0)
+      continue;
+    else if(!(fp=fopen(argv[i],"rb"))){
+      fprintf(stderr,"File not found: %s\n",argv[i]);
+      exit(1);
+    }
+    read_jobs(fp);
+    if(fp!=stdin)
+      fclose(fp);
+  }
+
+  sudoku_phase(ctx,PHASE_PARSE,t);
+
+  /* Solve and print out in input order*/
+  if(!sudoku_batch(ctx,jobs,n_jobs,0)){
+    fprintf(stderr,"Can't start the workers.\n");
+    exit(1);
+  }
+  t=sudoku_now();
+  for(i=0; i<n_jobs; ++i)
+    print_job(i,stdout);
+  sudoku_phase(ctx,PHASE_OUTPUT,t);
+
+  fprintf(stderr,"%d puzzles, %e(s)\n",n_jobs,(sudoku_now()-start)*1e-9);
+  if(ctx->stats_format)
+    sudoku_print_stats(ctx,stderr);
+  if(ctx->timing)
+    sudoku_print_timing(ctx,stderr);
+  if(ctx->trace_file && !sudoku_write_trace(ctx,ctx->trace_file))
+    fprintf(stderr,"Can't write %s\n",ctx->trace_file);
+  free(jobs);
+  sudoku_delete(ctx);
+  return 0;
+}
+/****************MAIN************/
+/* Add every puzzle of a stream (pipe,...) to jobs*/
+// The stream is read at once and parsed like a memory-mapped file.
+void read_jobs(FILE *fp){
+  char *buf=NULL,*p;
+  size_t len=0,size=0,n;
+  if(ctx->format!=FORMAT_TEXT){
+    load_jobs(fp);
+    return;
+  }
+  do{
+    if(len==size){
+      size=size ? 2*size : 1<<20;
+      if(!(p=realloc(buf,size))){
+	fprintf(stderr,"Out of memory.\n");
+	exit(1);
+      }
+      buf=p;
+    }
+    n=fread(buf+len,1,size-len,fp);
+    len+=n;
+  }while(n>0);
+  if(sudoku_parse(buf,len,&jobs,&n_jobs,&max_jobs)<0){
+    fprintf(stderr,"Out of memory.\n");
+    exit(1);
+  }
+  free(buf);
+}
+/* Add every binary record of a stream to jobs*/
+void load_jobs(FILE *fp){
+  int table[SIZE][SIZE];
+  while(sudoku_load(fp,table,ctx->format))
+    add_job(table);
+}
+void add_job(int table[][SIZE]){
+  int row,col;
+  if(n_jobs==max_jobs){
+    max_jobs=max_jobs ? 2*max_jobs : 1024;
+    if(!(jobs=realloc(jobs,max_jobs*sizeof(sudoku_job)))){
+      fprintf(stderr,"Out of memory.\n");
+      exit(1);
+    }
+  }
+  for(row=0; row<SIZE; ++row)
+    for(col=0; col<SIZE; ++col)
+      jobs[n_jobs].grid[row*SIZE+col]=table[row][col];
+  ++n_jobs;
+}
+/* Print out the status and the solution of a job*/
+void print_job(int i,FILE *fp){
+  int k;
+  fprintf(fp,"%d %s ",i+1,status_name[jobs[i].status]);
+  if(jobs[i].status==JOB_SOLVED || jobs[i].status==JOB_MULTIPLE){
+    for(k=0; k<SIZE*SIZE; ++k)
+      fputc(SYMBOLS[jobs[i].solution[k]],fp);
+  }
+  else
+    fputc('-',fp);
+  fputc('\n',fp);
+}
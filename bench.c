@@ -0,0 +1,134 @@
+/*Project: Sudoku Creator
+  Description: Benchmark of the solver modes.
+  Every puzzle of the files given (SIZE lines or one line of SIZE*SIZE
+  digits per puzzle) is solved once by every mode, searching up to a
+  second solution like the generator does. For every mode the median,
+  p99 and maximum time, and the mean numbers of nodes and backtracks
+  per puzzle are printed.
+  -o file : also write one CSV line per puzzle and mode
+  -m mode : run this mode only (may be repeated)*/
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include"sudoku.h"
+
+#define MAX_OPTIONS 3
+
+/* Solver modes: options of sudoku_option()*/
+struct mode{
+  const char *name;
+  const char *options[MAX_OPTIONS];
+};
+
+const struct mode modes[]={
+  {"fixed",{NULL}},
+  {"mrv",{"--mrv",NULL}},
+  {"dlx",{"--dlx",NULL}},
+  {"mrv-nopropagate",{"--mrv","--no-propagate",NULL}},
+};
+#define N_MODES (int)(sizeof(modes)/sizeof(modes[0]))
+
+/* Variables*/
+sudoku_job *jobs;
+int n_jobs,max_jobs;
+double *times;    // seconds of every puzzle of a mode
+
+/*Functions*/
+void run_mode(const struct mode *m,FILE *csv);
+int compare(const void *a,const void *b);
+
+/****************MAIN************/
+int main(int argc, char **argv){
+  FILE *csv=NULL;
+  int selected[N_MODES]={0},any=0;
+  int i,k;
+
+  /* Options come before the file names*/
+  for(i=1; i<argc && argv[i][0]=='-'; ++i){
+    if(!strcmp(argv[i],"-o") && i+1<argc){
+      if(!(csv=fopen(argv[++i],"w"))){
+	fprintf(stderr,"Create File Error.\n");
+	exit(1);
+      }
+    }
+    else if(!strcmp(argv[i],"-m") && i+1<argc){
+      for(k=0; k<N_MODES && strcmp(modes[k].name,argv[i+1]); ++k);
+      if(k==N_MODES){
+	fprintf(stderr,"Unknown mode %s\n",argv[i+1]);
+	exit(1);
+      }
+      selected[k]=any=1;
+      ++i;
+    }
+    else{
+      fprintf(stderr,"Unknown option %s\n",argv[i]);
+      exit(1);
+    }
+  }
+  if(i==argc){
+    fprintf(stderr,"usage: bench [-o file.csv] [-m mode] puzzle files\n");
+    exit(1);
+  }
+  for(; i<argc; ++i){
+    if(sudoku_map(argv[i],&jobs,&n_jobs,&max_jobs)<0){
+      fprintf(stderr,"File not found: %s\n",argv[i]);
+      exit(1);
+    }
+  }
+  if(!(times=malloc((n_jobs ? n_jobs : 1)*sizeof(double)))){
+    fprintf(stderr,"Out of memory.\n");
+    exit(1);
+  }
+
+  if(csv)
+    fprintf(csv,"mode,puzzle,seconds,nodes,backtracks,status\n");
+  printf("%d puzzles\n",n_jobs);
+  printf("%-16s %12s %12s %12s %12s %12s\n","mode","median(s)","p99(s)",
+	 "max(s)","nodes","backtracks");
+  for(k=0; k<N_MODES; ++k)
+    if(!any || selected[k])
+      run_mode(&modes[k],csv);
+  if(csv)
+    fclose(csv);
+  free(times);
+  free(jobs);
+  return 0;
+}
+/****************MAIN************/
+/* Solve every puzzle with a mode and print out its statistics*/
+void run_mode(const struct mode *m,FILE *csv){
+  sudoku_ctx *ctx=sudoku_new();
+  long long start;
+  double nodes=0,backtracks=0;
+  int i,k;
+
+  if(!ctx){
+    fprintf(stderr,"Out of memory.\n");
+    exit(1);
+  }
+  for(k=0; k<MAX_OPTIONS && m->options[k]; ++k)
+    sudoku_option(ctx,m->options[k]);
+  for(i=0; i<n_jobs; ++i){
+    start=sudoku_now();
+    sudoku_solve_job(ctx,&jobs[i]);
+    times[i]=(sudoku_now()-start)*1e-9;
+    nodes+=ctx->n_nodes;
+    backtracks+=ctx->n_backtracks;
+    if(csv)
+      fprintf(csv,"%s,%d,%.9f,%ld,%ld,%d\n",m->name,i+1,times[i],
+	      ctx->n_nodes,ctx->n_backtracks,jobs[i].status);
+  }
+  sudoku_delete(ctx);
+
+  if(!n_jobs)
+    return;
+  qsort(times,n_jobs,sizeof(double),compare);
+  printf("%-16s %12.3e %12.3e %12.3e %12.1f %12.1f\n",m->name,
+	 times[n_jobs/2],times[(n_jobs-1)*99/100],times[n_jobs-1],
+	 nodes/n_jobs,backtracks/n_jobs);
+}
+
+int compare(const void *a,const void *b){
+  double x=*(const double *)a,y=*(const double *)b;
+  return x<y ? -1 : x>y;
+}
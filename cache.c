@@ -0,0 +1,85 @@
+/*Project: Sudoku Creator
+  Description: Cache of uniqueness results of the generator.
+  The solution (c->known) is fixed while a puzzle is generated, so a
+  puzzle is given by the mask of its given grids. Removing symmetric
+  pairs in different orders reaches the same mask many times: the
+  cache remembers whether it was unique.
+  Direct-mapped: an entry is overwritten by the next mask hashed there.*/
+
+#include<stdlib.h>
+#include<string.h>
+#include"sudoku.h"
+
+#define UNKNOWN 0
+#define NOT_UNIQUE 1
+#define UNIQUE 2
+
+struct entry{
+  sudoku_mask key;
+  int state;        // UNKNOWN, NOT_UNIQUE or UNIQUE
+};
+
+struct sudoku_cache{
+  unsigned long mask;   // number of entries-1 (a power of 2 minus 1)
+  struct entry entries[];
+};
+
+/* Entry of a mask*/
+static struct entry *lookup(struct sudoku_cache *h,const sudoku_mask given){
+  unsigned long long x=0;
+  int i;
+  for(i=0; i<MASK_WORDS; ++i)
+    x=(x^given[i])*0x9e3779b97f4a7c15ull;
+  return &h->entries[(x^x>>29)&h->mask];
+}
+
+/* Allocate the cache with c->cache_size entries (rounded to a power of 2)*/
+static struct sudoku_cache *cache(sudoku_ctx *c){
+  unsigned long n=1;
+  if(c->cache || c->cache_size<=0)
+    return c->cache;
+  while(n<(unsigned long)c->cache_size)
+    n<<=1;
+  if((c->cache=calloc(1,sizeof(struct sudoku_cache)+n*sizeof(struct entry))))
+    c->cache->mask=n-1;
+  return c->cache;
+}
+
+/* Uniqueness of the puzzle with given grids "given"*/
+// Return 1 (unique), 0 (not unique) or -1 (unknown).
+int sudoku_cache_get(sudoku_ctx *c,const sudoku_mask given){
+  struct sudoku_cache *h=cache(c);
+  struct entry *e;
+  if(!h)
+    return -1;
+  e=lookup(h,given);
+  if(e->state==UNKNOWN || memcmp(e->key,given,sizeof(sudoku_mask))){
+    ++c->cache_misses;
+    return -1;
+  }
+  ++c->cache_hits;
+  return e->state==UNIQUE;
+}
+
+void sudoku_cache_put(sudoku_ctx *c,const sudoku_mask given,int unique){
+  struct sudoku_cache *h=cache(c);
+  struct entry *e;
+  if(!h)
+    return;
+  e=lookup(h,given);
+  memcpy(e->key,given,sizeof(sudoku_mask));
+  e->state=unique ? UNIQUE : NOT_UNIQUE;
+}
+
+/* Forget every puzzle (c->known has changed)*/
+void sudoku_cache_clear(sudoku_ctx *c){
+  struct sudoku_cache *h=c->cache;
+  if(h)
+    memset(h->entries,0,(h->mask+1)*sizeof(struct entry));
+  c->cache_hits=c->cache_misses=0;
+}
+
+void sudoku_cache_free(sudoku_ctx *c){
+  free(c->cache);
+  c->cache=NULL;
+}
@@ -0,0 +1,93 @@
+/*Project: Sudoku Creator
+  Description: Checkpoints of the generator (--checkpoint, invent --resume).
+  A checkpoint holds the settings of a generation, the given solution,
+  the best puzzle found, the uniqueness checks done and, for every
+  thread, its trials done and its random numbers at the start of its
+  current trial. A resumed thread draws the same samples again, so the
+  trial that was running is searched again from its start.
+  The file is text:
+    sudoku-checkpoint <SIZE>
+    seed <seed>
+    trials <trials>
+    empty <min_empty> <max_sample> <limit_empty>
+    checks <checks>
+    solution <SIZE*SIZE symbols>
+    best <max_empty> <SIZE*SIZE symbols, 0 for empty grids>
+    threads <n>
+    <trials done> <rng[0]> <rng[1]> <rng[2]> <rng[3]>   (n lines)*/
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include"sudoku.h"
+
+#define MAX_PATH 4096
+
+static void write_table(FILE *fp,int table[][SIZE]){
+  int k,v;
+  for(k=0; k<SIZE*SIZE; ++k){
+    v=table[k/SIZE][k%SIZE];
+    fputc(v==EMPTY ? '0' : SYMBOLS[v],fp);
+  }
+  fputc('\n',fp);
+}
+
+/* Write the checkpoint of the generation of c to c->checkpoint*/
+// The file is written next to it and renamed, so a checkpoint is never
+// half written. Return 0 on failure.
+int sudoku_write_checkpoint(sudoku_ctx *c,long checks){
+  char tmp[MAX_PATH];
+  FILE *fp;
+  int i;
+
+  if(snprintf(tmp,sizeof(tmp),"%s.tmp",c->checkpoint)>=(int)sizeof(tmp) ||
+     !(fp=fopen(tmp,"w")))
+    return 0;
+  fprintf(fp,"sudoku-checkpoint %d\nseed %llu\ntrials %d\nempty %d %d %d\nchecks %ld\n",
+	  SIZE,c->seed,c->trials,c->min_empty,c->max_sample,c->limit_empty,checks);
+  fprintf(fp,"solution ");
+  write_table(fp,c->sudoku);
+  fprintf(fp,"best %d ",c->max_empty);
+  write_table(fp,c->result);
+  fprintf(fp,"threads %d\n",c->n_states);
+  for(i=0; i<c->n_states; ++i)
+    fprintf(fp,"%d %llu %llu %llu %llu\n",c->states[i].done,c->states[i].rng[0],
+	    c->states[i].rng[1],c->states[i].rng[2],c->states[i].rng[3]);
+  if(fclose(fp)){
+    remove(tmp);
+    return 0;
+  }
+  return !rename(tmp,c->checkpoint);
+}
+
+/* Read a checkpoint: the next sudoku_generate_parallel(c) goes on
+   from it with its settings and c->n_threads threads*/
+// Return 0 if the file can't be read or was written for another SIZE.
+int sudoku_resume(sudoku_ctx *c,const char *path){
+  char solution[SIZE*SIZE+1],best[SIZE*SIZE+1],format[32];
+  struct sudoku_state *s=NULL;
+  FILE *fp;
+  int size,n=0,i,ok;
+
+  if(!(fp=fopen(path,"r")))
+    return 0;
+  sprintf(format," solution %%%ds best %%d %%%ds",SIZE*SIZE,SIZE*SIZE);
+  ok=fscanf(fp,"sudoku-checkpoint %d seed %llu trials %d empty %d %d %d checks %ld",
+	    &size,&c->seed,&c->trials,&c->min_empty,&c->max_sample,&c->limit_empty,
+	    &c->n_checks)==7 && size==SIZE &&
+    fscanf(fp,format,solution,&c->max_empty,best)==3 &&
+    sudoku_scan(solution,c->sudoku) && sudoku_scan(best,c->result) &&
+    fscanf(fp," threads %d",&n)==1 && n>0 && (s=calloc(n,sizeof(struct sudoku_state)));
+  for(i=0; ok && i<n; ++i)
+    ok=fscanf(fp,"%d %llu %llu %llu %llu",&s[i].done,&s[i].rng[0],&s[i].rng[1],
+	      &s[i].rng[2],&s[i].rng[3])==5;
+  fclose(fp);
+  if(!ok){
+    free(s);
+    return 0;
+  }
+  free(c->states);
+  c->states=s;
+  c->n_states=c->n_threads=n;
+  return 1;
+}
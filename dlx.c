@@ -0,0 +1,191 @@
+/*Project: Sudoku Creator
+  Description: Dancing Links (Algorithm X) engine.
+  The modified table is an exact cover problem with 4*SIZE*SIZE
+  constraints, each of which must be covered exactly once:
+  * grid (row,col) has a value
+  * row "row" has value "val"
+  * column "col" has value "val"
+  * block[row][col/BOX_H] has a value of group val/BOX_W
+  A choice (row,col,val) covers one constraint of each kind.*/
+
+#include<stdlib.h>
+#include"sudoku.h"
+
+#define N_COLUMNS (4*SIZE*SIZE)
+#define N_NODES (1+N_COLUMNS+4*SIZE*SIZE*SIZE)
+#define ROOT 0
+
+/* Workspace of a context.
+   Nodes: 0 is the root, 1..N_COLUMNS are column headers*/
+struct dlx{
+  int L[N_NODES],R[N_NODES],U[N_NODES],D[N_NODES];
+  int C[N_NODES];          // column header of a node
+  int choice[N_NODES];     // row*SIZE*SIZE+col*SIZE+val of a node
+  int S[N_COLUMNS+1];      // number of nodes in a column
+  int n_used;              // number of nodes in use
+};
+
+#define L (x->L)
+#define R (x->R)
+#define U (x->U)
+#define D (x->D)
+#define C (x->C)
+#define S (x->S)
+
+/* Remove column c and every choice that covers it*/
+static void cover(struct dlx *x,int c){
+  int i,j;
+  R[L[c]]=R[c];
+  L[R[c]]=L[c];
+  for(i=D[c]; i!=c; i=D[i]){
+    for(j=R[i]; j!=i; j=R[j]){
+      D[U[j]]=D[j];
+      U[D[j]]=U[j];
+      --S[C[j]];
+    }
+  }
+}
+
+/* Reverse cover(c)*/
+static void uncover(struct dlx *x,int c){
+  int i,j;
+  for(i=U[c]; i!=c; i=U[i]){
+    for(j=L[i]; j!=i; j=L[j]){
+      ++S[C[j]];
+      D[U[j]]=j;
+      U[D[j]]=j;
+    }
+  }
+  R[L[c]]=c;
+  L[R[c]]=c;
+}
+
+/* Add a choice (row,col,val) covering 4 columns*/
+static void add_choice(struct dlx *x,int row,int col,int val){
+  int cols[4],i,n;
+  cols[0]=1+row*SIZE+col;
+  cols[1]=1+SIZE*SIZE+row*SIZE+val;
+  cols[2]=1+2*SIZE*SIZE+col*SIZE+val;
+  cols[3]=1+3*SIZE*SIZE+row*SIZE+col/BOX_H*(SIZE/BOX_W)+val/BOX_W;
+  for(i=0; i<4; ++i){
+    n=x->n_used++;
+    C[n]=cols[i];
+    x->choice[n]=(row*SIZE+col)*SIZE+val;
+    /* vertical: insert at the bottom of column*/
+    U[n]=U[cols[i]];
+    D[n]=cols[i];
+    D[U[n]]=n;
+    U[cols[i]]=n;
+    ++S[cols[i]];
+    /* horizontal: circular list of the 4 nodes*/
+    if(i==0)
+      L[n]=R[n]=n;
+    else{
+      L[n]=n-1;
+      R[n]=n-i;
+      R[n-1]=n;
+      L[n-i]=n;
+    }
+  }
+}
+
+/* Build the exact cover matrix from the used state made by init()*/
+static void build(sudoku_ctx *ctx,struct dlx *x){
+  unsigned int cand;
+  int c,row,col,i,last;
+
+  /* Column headers. Constraints already covered by the given numbers
+     are left out of the header list.*/
+  last=ROOT;
+  L[ROOT]=R[ROOT]=ROOT;
+  for(c=1; c<=N_COLUMNS; ++c){
+    U[c]=D[c]=c;
+    S[c]=0;
+    C[c]=c;
+    i=(c-1)%(SIZE*SIZE);
+    row=i/SIZE;
+    col=i%SIZE;
+    switch((c-1)/(SIZE*SIZE)){
+    case 0: if(ctx->problem[row][col]!=EMPTY) continue; break;
+    case 1: if(ctx->rows[row]>>col&1) continue; break;
+    case 2: if(ctx->column[row]>>col&1) continue; break;
+    case 3: if(ctx->block[row][col/(SIZE/BOX_W)]>>(col%(SIZE/BOX_W)*BOX_W)&1) continue; break;
+    }
+    L[c]=last;
+    R[last]=c;
+    last=c;
+  }
+  L[ROOT]=last;
+  R[last]=ROOT;
+  x->n_used=N_COLUMNS+1;
+
+  /* One choice for every candidate of every empty grid*/
+  for(row=0; row<SIZE; ++row){
+    for(col=0; col<SIZE; ++col){
+      if(ctx->problem[row][col]!=EMPTY)
+	continue;
+      for(cand=CANDIDATES(ctx,row,col); cand; cand&=cand-1)
+	add_choice(x,row,col,__builtin_ctz(cand));
+    }
+  }
+}
+
+/* Algorithm X: cover the column with the fewest choices first.
+   Choices are mirrored in ctx->problem for sudoku_solution().*/
+static void dlx(sudoku_ctx *ctx,struct dlx *x){
+  int c=ROOT,i,j,min,k;
+
+  if(R[ROOT]==ROOT){   // every constraint is covered
+    ++ctx->n_ans;
+    STAT(ctx,solutions);
+    if(ctx->solution_found)
+      ctx->solution_found(ctx);
+    return;
+  }
+  min=N_NODES;
+  for(j=R[ROOT]; j!=ROOT; j=R[j]){
+    if(S[j]<min){
+      min=S[j];
+      c=j;
+      if(min<=1)
+	break;
+    }
+  }
+  if(min==0){
+    ++ctx->n_backtracks;   // dead end
+    return;
+  }
+
+  cover(x,c);
+  for(i=D[c]; i!=c; i=D[i]){
+    k=x->choice[i];
+    ctx->problem[k/SIZE/SIZE][k/SIZE%SIZE]=k%SIZE;
+    ++ctx->n_nodes;
+    STAT_ENTER(ctx);
+    for(j=R[i]; j!=i; j=R[j])
+      cover(x,C[j]);
+    dlx(ctx,x);
+    for(j=L[i]; j!=i; j=L[j])
+      uncover(x,C[j]);
+    STAT_LEAVE(ctx);
+    ctx->problem[k/SIZE/SIZE][k/SIZE%SIZE]=EMPTY;
+    if(ctx->max_ans && ctx->n_ans>=ctx->max_ans)
+      break;
+  }
+  uncover(x,c);
+}
+
+/* Search the state made by sudoku_init() with Dancing Links*/
+int sudoku_dlx_search(sudoku_ctx *ctx){
+  if(!ctx->dlx && !(ctx->dlx=malloc(sizeof(struct dlx))))
+    return ctx->n_ans;
+  build(ctx,ctx->dlx);
+  dlx(ctx,ctx->dlx);
+  return ctx->n_ans;
+}
+
+/* Release the workspace*/
+void sudoku_dlx_free(sudoku_ctx *ctx){
+  free(ctx->dlx);
+  ctx->dlx=NULL;
+}
@@ -6,56 +6,42 @@
 #include<stdlib.h>
 #include<time.h>
 #include<string.h>
-#define SIZE 9
-/* Initially, value of members of an array are zero, while 
-   every position is available with any value.
-   That's why AVAILABLE is defined as 0 to reduce one
-   initializing step.*/
-#define AVAILABLE 0
-#define TRUE 1
-#define FALSE 0
-#define EMPTY -1
-#define MAX_ANS 1    /* biggest number of solutions allowed*/
-/* Problem*/
-int sudoku[SIZE][SIZE];
-/* Variables used to find solutions*/
-int sudoku_modified[SIZE][SIZE];
-int problem[SIZE][SIZE];
-int row_index[SIZE];
-int positive[SIZE];
-/* Availble state representing*/
-int column[SIZE][SIZE];
-int rows[SIZE][SIZE];
-int block[SIZE][SIZE/3][SIZE/3];
-/*column[col][val]=AVAILABLE means "val" can be put into column "col"
-  rows[row][val]=AVAILABLE means "val" can be put into row "row"
-  block[row/3][col/3][val]=AVAILABLE means "val" can be put into the block 
-  that includes (row,col) mass.*/
+#include"sudoku.h"
+#define BUFFER_SIZE (1<<20)   // buffer of the solution file and stdout
 /* Variables*/
-int n_ans;   /* number of answers*/
+sudoku_ctx *ctx;
 FILE *fp;     
+int quiet;        /* --quiet: solutions are saved, not printed*/
+int count_only;   /* --count: solutions are only counted*/
+int first;        /* --first=K: stop after K solutions (0: all)*/
 /*Functions*/
 /* In-Out functions and Initializing functions*/
-void get_sudoku(FILE* fp);    /* get sudoku from a file*/
-void sudoku_to_problem();
-void problem_to_sudoku(void);
-void print_table(int table[][SIZE],FILE*);   /* print a table*/
-void copy_table(int to[][SIZE],int from[][SIZE]);    /* copy two tables*/
-void save_table(int table[][SIZE],FILE *fp);
-void init();   /* initialization
+void print_solution(sudoku_ctx *c);    /* print and save the solution just found*/
 /* Finding solutions functions*/
-int put(int k);    /* recursively put a number into sudoku table*/
-void update(int row,int col,int val);    /* place "val" into (row,col) and update available state */
-void remove_update(int row,int col,int val);    /* remove "val" from (row,col) and reverse last update*/
 void find_solutions();
-void create(); /* Create new puzzle functions*/
 /****************MAIN************/
 int main(int argc, char **argv){
-  clock_t start,end;
-  int row;
+  long long start,t;
+  int i;
   char line[100],solution_file_name[100],input_file_name[100];   
   /* name of file in which solutions are written and name of input file*/
-  start=clock(); 
+  start=sudoku_now(); 
+  ctx=sudoku_new();
+  /* Options come before the file name*/
+  for(i=1; i<argc && argv[i][0]=='-'; ++i){
+    if(!strcmp(argv[i],"--quiet"))
+      quiet=1;
+    else if(!strcmp(argv[i],"--count"))
+      count_only=1;
+    else if(!strncmp(argv[i],"--first=",8))
+      first=atoi(argv[i]+8);
+    else if(!sudoku_option(ctx,argv[i])){
+      printf("Unknown option %s\n",argv[i]);
+      exit(1);
+    }
+  }
+  argc-=i-1;
+  argv+=i-1;
   /* get the puzzle from a file*/
   if(argc>1){
     strcpy(input_file_name,argv[1]);
@@ -65,249 +51,92 @@ int main(int argc, char **argv){
     fgets(line,sizeof(line),stdin);
     sscanf(line,"%s",input_file_name);
   }
-  for(row=0; row<SIZE; ++row)
-    row_index[row]=row;
   fp=fopen(input_file_name,"r");
   if(!fp){
     printf("File not found.\n");
     exit(1);
   }
-  get_sudoku(fp);
+  t=sudoku_now();
+  if(!sudoku_read(fp,ctx->sudoku)){
+    printf("Invalid puzzle file.\n");
+    exit(1);
+  }
+  sudoku_phase(ctx,PHASE_PARSE,t);
   fclose(fp);
+  fp=NULL;
   
   /* print out the sudoku puzzle*/
+  setvbuf(stdout,NULL,_IOFBF,BUFFER_SIZE);
   printf("The puzzle:\n");
-  print_table(sudoku,stdout);
+  sudoku_print(ctx->sudoku,stdout);
 
   /* Create a new file to store solutions*/
+  // --packed or --ranked: one binary record per solution
   strcpy(solution_file_name,input_file_name);
-  strcat(solution_file_name,"-solution.txt");
-  fp=fopen(solution_file_name,"w");
-  if(!fp){
-    printf("Create File Error.\n");
-    exit(1);
+  strcat(solution_file_name,ctx->format==FORMAT_TEXT ? "-solution.txt" : "-solution.bin");
+  if(!count_only){
+    fp=fopen(solution_file_name,"wb");
+    if(!fp){
+      printf("Create File Error.\n");
+      exit(1);
+    }
+    setvbuf(fp,NULL,_IOFBF,BUFFER_SIZE);
   }
 
   /* Find, print out, and save solutions*/
-  find_solutions();  /* find all solutions*/
-  fclose(fp);
+  find_solutions();  /* find all solutions (or the first ones)*/
+  if(fp)
+    fclose(fp);
   /* Check number of answers*/
-  if(n_ans==0)
+  if(count_only)
+    printf("%d solution(s).\n",ctx->n_ans);
+  else if(ctx->n_ans==0)
     printf("There is no solution.\n");
-  else if(n_ans==1){
+  else if(ctx->n_ans==1){
     printf("There is one solution.\n");
     printf("Solution is saved in file named %s\n",solution_file_name);
   }
   else{
-    printf("Thre are %d solutions.\n",n_ans);
+    printf("Thre are %d solutions.\n",ctx->n_ans);
     printf("Solutions are saved in file named %s\n",solution_file_name);	
   }
-  end=clock();
-  printf("Execution time: %e(s)\n",(double)(end-start)/CLOCKS_PER_SEC);
+  printf("Nodes searched: %ld\n",ctx->n_nodes);
+  if(ctx->stats_format)
+    sudoku_print_stats(ctx,stdout);
+  if(ctx->timing)
+    sudoku_print_timing(ctx,stdout);
+  if(ctx->trace_file && !sudoku_write_trace(ctx,ctx->trace_file))
+    fprintf(stderr,"Can't write %s\n",ctx->trace_file);
+  sudoku_delete(ctx);
+  printf("Execution time: %e(s)\n",(sudoku_now()-start)*1e-9);
   return 0;
 }
 /****************MAIN************/
 /* Find solutions function*/
 void find_solutions(){
-  n_ans=0;
-  init();   /* initialization*/
-  put(0);   /* recursively place numbers*/
-}
-/* Initialization*/
-void init(){
-  int row,col,val; 
-  sudoku_to_problem();
-  copy_table(problem,sudoku_modified);
-  /* Initialize available state of sudoku puzzles!
-     If there is a conflict, exit program*/
-  for(row=0; row<SIZE; ++row){
-    for(col=0; col<SIZE; ++col){
-      if((val=sudoku_modified[row][col])>=0){
-	if(column[col][val]==!AVAILABLE||
-	   rows[row][val]==!AVAILABLE||
-	   block[row][col/3][val/3]==!AVAILABLE){
-	  fprintf(stderr,"The input problem has a conflict.\n");
-	  fprintf(stderr,"%d can't be in (%d,%d) grid.\n",row_index[row]+1,col+1,val+1);
-	  exit(1);
-	}
-	column[col][val]=!AVAILABLE;
-	rows[row][val]=!AVAILABLE;
-	block[row][col/3][val/3]=!AVAILABLE;
-      }
-    }
-  } 
-}
-/* Recursively put a number into sudoku table*/
-int put(int k){
-  int val,col,row;
-  row=k/9;  /* row number*/
-  col=k%9;  /* column number*/
-  /* If a number is originally placed in (rol,cow) mass
-  ---> no number can be put there*/
-  if(sudoku_modified[row][col]!=EMPTY){
-    if(k<SIZE*SIZE-1) /* If this is not the last*/
-      put(k+1);       /* put a number to the next mass.*/
-    else{             /* Otherwise, a solution is found.*/
-      ++n_ans;        /* Increment number of answers*/
-      printf("#%d solution:\n",n_ans);
-      problem_to_sudoku(); /* print the solution*/
-    }
-  }
-
-  else{
-    for(val=0; val<SIZE; ++val){
-      /* If "val" can be put into (row,col) mass*/
-      if(column[col][val]==AVAILABLE &&
-	 rows[row][val]==AVAILABLE &&
-	 block[row][col/3][val/3]==AVAILABLE){
-	update(row,col,val);
-	if(k<SIZE*SIZE-1){
-	  put(k+1);
-	}
-	else{
-	  ++n_ans;
-	  printf("#%d solution:\n",n_ans);
-	  problem_to_sudoku();
-	}
-	remove_update(row,col,val);    /* remove "val" from (row,col) mass*/
-      }
-    }
-  }
-  return n_ans;
-}
-/* Get sudoku puzzle from a file*/
-void get_sudoku(FILE *fp){
-  char line[100],str[SIZE];
-  int row,col;
-  for(row=0; row<SIZE; ++row){
-    fgets(line,sizeof(line),fp);
-    sscanf(line,"%s",str);
-    for(col=0; col<SIZE; ++col){
-      sudoku[row][col]=str[col]-'1';
-    }
-  }
-}
-/* Swap two integers*/
-void swap_int(int *x, int *y){
-  int tmp=*x;
-  *x=*y;
-  *y=tmp;
-}
-/* Swap two rows of a table*/
-void swap_row(int arr[][SIZE],int m, int n){
-  int i;
-  for(i=0; i<SIZE; ++i)
-    swap_int(&arr[m][i],&arr[n][i]);
-}
-/* Conver sudoku puzzle*/
-void sudoku_to_problem(void){
-  int row,col,val;
-  int i,j;
-
-  for(row=0; row<SIZE; ++row){
-    for(col=0; col<SIZE; ++col){
-      sudoku_modified[row][col]=EMPTY;
-    }
-  }
-  
-  for(row=0; row<SIZE; ++row){
-    for(col=0; col<SIZE; ++col){
-      if((val=sudoku[row][col])!=EMPTY){
-	sudoku_modified[val][row]=col;
-	++positive[val];
-      }
-    }
-  }  
-  
-  for(i=0; i<SIZE-1; ++i){
-    for(j=i+1;j<SIZE; ++j){
-      if(positive[j]>positive[i]){
-	swap_row(sudoku_modified,i,j);
-	swap_int(&row_index[i],&row_index[j]);
-      }
-    }
-  }
-}
-/* Problem to sudoku*/
-void problem_to_sudoku(){
-  static sudoku_tmp[SIZE][SIZE],problem_tmp[SIZE][SIZE];
-  int row,col,val;
-  
-  for(row=0; row<SIZE; ++row){
-    for(col=0; col<SIZE; ++col){
-      problem_tmp[row_index[row]][col]=problem[row][col];
-    }
-  }
-  
-  for(row=0; row<SIZE; ++row){
-    for(col=0; col<SIZE; ++col){
-      sudoku_tmp[col][problem_tmp[row][col]]=row;
-    }
-  }
-  print_table(sudoku_tmp,stdout);
-  save_table(sudoku_tmp,fp);
-}
-/* Print a table*/
-void print_table(int table[][SIZE],FILE *fp){
-  int row,col;
-  for(row=0; row<SIZE; ++row){
-    for(col=0; col<SIZE; ++col){
-      if(table[row][col]>=0)
-	fprintf(fp,"%d ",table[row][col]+1);
-      else
-	fprintf(fp,"* ");
-    }
-    fprintf(fp,"\n");
-  }
-  fprintf(fp,"\n");
-}
-/* Copy two tables*/
-void copy_table(int to[][SIZE],int from[][SIZE]){
-  int row,col;
-  for(row=0; row<SIZE; ++row){
-    for(col=0; col<SIZE; ++col){
-      to[row][col]=from[row][col];
-    }
-  }
-}
-/* Save table*/
-void save_table(int table[][SIZE],FILE *fp){
-  int row,col;
-  for(row=0; row<SIZE; ++row){
-    for(col=0; col<SIZE; ++col){
-      if(table[row][col]>=0)
-	fprintf(fp,"%d",table[row][col]+1);
-      else
-	fprintf(fp,"0");
-    }
-    fprintf(fp,"\n");
+  int k;
+  ctx->n_ans=0;
+  ctx->max_ans=first;   /* 0: find all solutions*/
+  ctx->solution_found=count_only ? NULL : print_solution;
+  /* initialization. If there is a conflict, exit program*/
+  if((k=sudoku_init(ctx))>=0){
+    fprintf(stderr,"The input problem has a conflict.\n");
+    fprintf(stderr,"%d can't be in (%d,%d) grid.\n",ctx->row_index[k/SIZE]+1,
+	    k%SIZE+1,ctx->sudoku_modified[k/SIZE][k%SIZE]+1);
+    exit(1);
   }
-  fprintf(fp,"\n");
-}
-/* Put a new number into sudoku table and update correspondent available state*/
-void update(int row,int col, int val){
-  problem[row][col]=val;    /* value update*/
-  column[col][val]=!AVAILABLE;  /* column status update*/
-  rows[row][val]=!AVAILABLE;   /* rows status update*/
-  block[row][col/3][val/3]=!AVAILABLE;   /* block status update*/ 
-}
-
-/* Remove a new number from sudoku table and update correspondent available state*/
-void remove_update(int row,int col, int val){
-  problem[row][col]=EMPTY;
-  column[col][val]=AVAILABLE;
-  rows[row][val]=AVAILABLE;
-  block[row][col/3][val/3]=AVAILABLE;
+  sudoku_search(ctx);   /* place numbers*/
 }
-/* Number of empty grids in a puzzle*/
-int empty(){
-  int i,j,cnt;
-  cnt=0;
-  for(i=0; i<SIZE; ++i){
-    for(j=0; j<SIZE; ++j){
-      if(sudoku[i][j]==EMPTY)
-	++cnt;
-    }
-  }
-  return cnt;
+/* Print out and save the solution just found*/
+// The output phase is timed inside the search phase.
+void print_solution(sudoku_ctx *c){
+  int sudoku_tmp[SIZE][SIZE];
+  long long t=c->timing ? sudoku_now() : 0;
+  sudoku_solution(c,sudoku_tmp);
+  if(!quiet){
+    printf("#%d solution:\n",c->n_ans);
+    sudoku_print(sudoku_tmp,stdout);
+  }
+  sudoku_write(sudoku_tmp,fp,ctx->format);
+  sudoku_phase(c,PHASE_OUTPUT,t);
 }
@@ -0,0 +1,512 @@
+/*Project: Sudoku Creator
+  Description: Create Sudoku Puzzles satifying the following:
+  * It has one and only one solution (given)
+  * It has as many empty grids as possible (or limit_empty).
+  * It is point symmetric with its centre is symmetric centre.*/
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<limits.h>
+#include<signal.h>
+#include<string.h>
+#include<pthread.h>
+#include<stdatomic.h>
+#include"sudoku.h"
+
+/* Best result shared by the threads of sudoku_generate_parallel()*/
+// Every thread keeps its own result; they are compared when all are done.
+// Meanwhile every better puzzle is published to the parent context.
+// Trials are ordered as if they were dealt in turn: trial t of thread i
+// is number t*n_threads+i. A thread that finds limit_empty empty grids
+// records its trial in "hit"; the others go on until their trial comes
+// after the lowest one recorded, so the first success in that order is
+// the result, whatever the timing of the threads.
+struct sudoku_best{
+  atomic_int max_empty;    // biggest number of empty grids found
+  atomic_llong hit;        // lowest trial that found limit_empty empty grids (LLONG_MAX: none)
+  int n_threads;
+  atomic_long checks;      // uniqueness checks of all the threads
+  sudoku_ctx *parent;      // context of sudoku_generate_parallel()
+  pthread_mutex_t lock;    // publishing to the parent
+  long long next_checkpoint;   // sudoku_now() time of the next checkpoint
+};
+
+static void generate(sudoku_ctx *c,int n_empty);
+
+#define N_GRIDS (SIZE*SIZE)
+#define N_PAIRS (N_GRIDS/2)     // symmetric pairs (k,N_GRIDS-1-k)
+#define CENTRE (N_GRIDS%2)      // the centre grid is alone (SIZE is odd)
+
+/* A pair of grids removed by generate()*/
+struct removal{
+  short k;                // grids k and N_GRIDS-1-k
+  signed char val,sym;    // their numbers
+};
+
+/* Random numbers: xoshiro256** (Blackman and Vigna)*/
+static unsigned long long rotl(unsigned long long x,int k){
+  return x<<k|x>>(64-k);
+}
+
+static unsigned long long next(sudoku_ctx *c){
+  unsigned long long *s=c->rng;
+  unsigned long long r=rotl(s[1]*5,7)*9,t=s[1]<<17;
+  s[2]^=s[0];
+  s[3]^=s[1];
+  s[1]^=s[2];
+  s[0]^=s[3];
+  s[2]^=t;
+  s[3]=rotl(s[3],45);
+  return r;
+}
+
+/* Advance the state by 2^128 numbers: streams never overlap*/
+static void jump(sudoku_ctx *c){
+  static const unsigned long long JUMP[]={0x180ec6d33cfd0abaull,0xd5a61266f0c9392cull,
+					  0xa9582618e03fc9aaull,0x39abdc4529b1661cull};
+  unsigned long long s[4]={0};
+  int i,b,k;
+  for(i=0; i<4; ++i)
+    for(b=0; b<64; ++b){
+      if(JUMP[i]>>b&1)
+	for(k=0; k<4; ++k)
+	  s[k]^=c->rng[k];
+      next(c);
+    }
+  memcpy(c->rng,s,sizeof(s));
+}
+
+/* Start stream c->stream of seed c->seed (state filled by splitmix64)*/
+static void seed_rng(sudoku_ctx *c){
+  unsigned long long x=c->seed,z;
+  int i;
+  for(i=0; i<4; ++i){
+    z=(x+=0x9e3779b97f4a7c15ull);
+    z=(z^z>>30)*0xbf58476d1ce4e5b9ull;
+    z=(z^z>>27)*0x94d049bb133111ebull;
+    c->rng[i]=z^z>>31;
+  }
+  for(i=0; i<c->stream; ++i)
+    jump(c);
+}
+
+/* Random integer 0..n-1, unbiased (Lemire's multiply and reject)*/
+static int rand_n(sudoku_ctx *c,int n){
+  unsigned long long m=(next(c)>>32)*n;
+  unsigned int t;
+  if((unsigned int)m<(unsigned int)n){
+    t=-(unsigned int)n%n;
+    while((unsigned int)m<t)
+      m=(next(c)>>32)*n;
+  }
+  return m>>32;
+}
+
+/* Uniqueness checks done (by all threads)*/
+static long checks(sudoku_ctx *c){
+  return c->best ? atomic_load(&c->best->checks) : c->n_checks;
+}
+
+/* Number of the trial running in the order of struct sudoku_best*/
+static long long trial(sudoku_ctx *c){
+  return (long long)c->trial*c->best->n_threads+c->stream;
+}
+
+/* Stop generating: a puzzle with limit_empty empty grids is found (by
+   this thread, or by another one in an earlier trial), the deadline or
+   the budget of checks is over, or the generation is cancelled*/
+static int done(sudoku_ctx *c){
+  struct sudoku_best *b=c->best;
+  if(atomic_load(&c->cancelled) ||
+     (b && (atomic_load(&b->hit)<trial(c) || atomic_load(&b->parent->cancelled))))
+    return 1;
+  if(c->limit_empty && c->max_empty>=c->limit_empty)
+    return 1;
+  if(c->max_checks && checks(c)>=c->max_checks)
+    return 1;
+  return c->stop_time && sudoku_now()>=c->stop_time;
+}
+
+/* Remember the puzzle in c->sudoku if it is the best one*/
+static void improve(sudoku_ctx *c,int n_empty){
+  struct sudoku_best *b=c->best;
+  sudoku_ctx *p;
+  long long hit;
+  int old;
+
+  if(n_empty>c->max_empty){
+    c->max_empty=n_empty;
+    sudoku_copy(c->result,c->sudoku);
+    if(c->improved)
+      c->improved(c);
+  }
+  if(!b)
+    return;
+  old=atomic_load(&b->max_empty);
+  while(n_empty>old && !atomic_compare_exchange_weak(&b->max_empty,&old,n_empty));
+  if(n_empty>old){
+    // the best one of all threads so far
+    p=b->parent;
+    pthread_mutex_lock(&b->lock);
+    if(n_empty>p->max_empty){
+      p->max_empty=n_empty;
+      sudoku_copy(p->result,c->sudoku);
+      if(p->improved)
+	p->improved(p);
+    }
+    pthread_mutex_unlock(&b->lock);
+  }
+  if(c->limit_empty && n_empty>=c->limit_empty){
+    // later trials of the other threads are cancelled
+    hit=atomic_load(&b->hit);
+    while(trial(c)<hit && !atomic_compare_exchange_weak(&b->hit,&hit,trial(c)));
+  }
+}
+
+/* Remember the state of thread c at the start of trial s_cnt and
+   write the checkpoint of the parent when it is due*/
+static void checkpoint(sudoku_ctx *c,int s_cnt){
+  struct sudoku_best *b=c->best;
+  struct sudoku_state *s;
+  long long now;
+
+  if(!b || !b->parent->checkpoint || !b->parent->states)
+    return;
+  pthread_mutex_lock(&b->lock);
+  s=&b->parent->states[c->stream];
+  memcpy(s->rng,c->rng,sizeof(c->rng));
+  s->done=s_cnt;
+  if((now=sudoku_now())>=b->next_checkpoint){
+    sudoku_write_checkpoint(b->parent,atomic_load(&b->checks));
+    b->next_checkpoint=now+b->parent->checkpoint_interval*1000000000LL;
+  }
+  pthread_mutex_unlock(&b->lock);
+}
+
+/* Stop the generation of c as soon as possible*/
+// The best puzzle found so far is kept. The flag stays set: clear
+// c->cancelled before generating again with c.
+void sudoku_cancel(sudoku_ctx *c){
+  atomic_store(&c->cancelled,1);
+}
+
+/* Ctrl+C or SIGTERM cancels the generation of this context*/
+static sudoku_ctx *signalled;
+
+static void on_signal(int sig){
+  sudoku_cancel(signalled);
+  signal(sig,SIG_DFL);   // a second Ctrl+C (SIGTERM) quits
+}
+
+/* Stop the generation of c on Ctrl+C or SIGTERM (a batch job being
+   preempted): it returns with the best puzzle found and, with
+   c->checkpoint, saves the last checkpoint*/
+void sudoku_stop_on_signals(sudoku_ctx *c){
+  signalled=c;
+  signal(SIGINT,on_signal);
+  signal(SIGTERM,on_signal);
+}
+
+/* c->sudoku is a complete solution without conflict (sudoku_init() is done)*/
+// Otherwise the problem is printed and 0 is returned.
+int sudoku_check_solution(sudoku_ctx *c){
+  int row,col,k;
+  for(row=0; row<SIZE; ++row)
+    for(col=0; col<SIZE; ++col)
+      if(c->sudoku[row][col]==EMPTY){
+	printf("The input puzzle has an empty grid (%d,%d)\n",row+1,col+1);
+	return 0;
+      }
+  if((k=sudoku_init(c))>=0){
+    fprintf(stderr,"The input solution has a conflict.\n");
+    fprintf(stderr,"%d can't be in (%d,%d) grid.\n",c->row_index[k/SIZE]+1,
+	    k%SIZE+1,c->sudoku_modified[k/SIZE][k%SIZE]+1);
+    return 0;
+  }
+  return 1;
+}
+
+/* The puzzle c->sudoku has one and only one solution*/
+// Unavoidable sets reject it at once, then the cache answers the puzzles
+// already tested. Otherwise it is searched.
+// init: build the state of c->sudoku (sudoku_init()) before searching;
+// a unique puzzle is always left initialized.
+static int unique(sudoku_ctx *c,int init){
+  sudoku_mask given;
+  int r;
+
+  ++c->n_checks;
+  if(c->best)
+    atomic_fetch_add(&c->best->checks,1);
+  sudoku_mask_of(c->sudoku,given);
+  if(!sudoku_covers(c,given)){
+    STAT(c,set_rejects);
+    return 0;
+  }
+  if((r=sudoku_cache_get(c,given))<0){
+    r=(!init || sudoku_init(c)<0) && sudoku_unique(c);
+    sudoku_cache_put(c,given,r);
+  }
+  else if(r && init)
+    sudoku_init(c);
+  return r;
+}
+
+
+/* Number of empty grids of the next sample*/
+// Uniform in [min_empty,max_sample).
+static int target(sudoku_ctx *c){
+  int n=c->max_sample-c->min_empty;
+  return n>1 ? c->min_empty+rand_n(c,n) : c->min_empty;
+}
+
+/* Empty exactly n_empty grids of the solution c->known.
+   Uniformly random among point symmetric puzzles: the centre is empty
+   when n_empty is odd and n_empty/2 of the N_PAIRS pairs (k,N_GRIDS-1-k)
+   are drawn by a partial Fisher-Yates shuffle.
+   Without a centre (SIZE even) an odd n_empty is rounded down.
+   Return the number of empty grids.*/
+static int sample(sudoku_ctx *c,int n_empty){
+  int pair[N_PAIRS];
+  int i,j,k;
+
+  sudoku_copy(c->sudoku,c->known);
+  if(!CENTRE)
+    n_empty&=~1;
+  else if(n_empty%2)
+    c->sudoku[SIZE/2][SIZE/2]=EMPTY;
+  for(i=0; i<N_PAIRS; ++i)
+    pair[i]=i;
+  for(i=0; i<n_empty/2 && i<N_PAIRS; ++i){
+    j=i+rand_n(c,N_PAIRS-i);
+    k=pair[j];
+    pair[j]=pair[i];
+    pair[i]=k;
+    c->sudoku[k/SIZE][k%SIZE]=EMPTY;
+    c->sudoku[SIZE-1-k/SIZE][SIZE-1-k%SIZE]=EMPTY;
+  }
+  return i<N_PAIRS ? n_empty : 2*N_PAIRS+n_empty%2;
+}
+
+/* Create a puzzle with as many empty grids as possible
+   by randomly assigning empty grids' positions.*/
+// c->sudoku is the given solution. It is restored before returning.
+// Generation stops after c->trials samples, at c->deadline, after
+// c->time_limit seconds, after c->max_checks uniqueness checks or when
+// it is cancelled: c->result is the best puzzle found by then, the
+// solution itself (max_empty 0) if no unique sample was found.
+int sudoku_generate(sudoku_ctx *c){
+  int n_empty;    // number of empty grids
+  int s_cnt;
+  int max_ans=c->max_ans;
+  void (*found)(sudoku_ctx *)=c->solution_found;
+  long long t;
+
+  c->stop_time=c->deadline;
+  if(c->time_limit){
+    t=sudoku_now()+c->time_limit*1000000000LL;
+    if(!c->stop_time || t<c->stop_time)
+      c->stop_time=t;
+  }
+  c->n_checks=0;
+  if(!c->trials_done)
+    seed_rng(c);
+
+  // Uniqueness is tested against the given solution (sudoku_unique())
+  c->max_ans=2;
+  c->solution_found=NULL;
+  c->max_empty=0;
+  sudoku_copy(c->known,c->sudoku);
+  sudoku_copy(c->result,c->sudoku);
+  // Puzzles emptying an unavoidable set are rejected without a search
+  sudoku_unavoidable(c);
+  sudoku_cache_clear(c);
+
+  // Simulating c->trials times, however, stop if processing time exceeds limited time
+  // Every sample has exactly target() empty grids, so every trial is
+  // a real uniqueness test.
+  for(s_cnt=c->trials_done; s_cnt<c->trials; ++s_cnt){
+    c->trial=s_cnt;
+    if(done(c))
+      break;
+    checkpoint(c,s_cnt);
+    n_empty=sample(c,target(c));
+    STAT(c,samples);
+    if(unique(c,1)){
+      STAT(c,samples_unique);
+      improve(c,n_empty);
+      generate(c,n_empty);    // Generate more empty grids
+    }
+  }
+  if(s_cnt==c->trials && !done(c))
+    checkpoint(c,s_cnt);    // every trial is over
+
+  // Return sudoku table to its original state
+  sudoku_copy(c->sudoku,c->known);
+  c->max_ans=max_ans;
+  c->solution_found=found;
+  return c->max_empty;
+}
+
+/* Put back the pair of grids removed by a frame of generate()*/
+static void restore(sudoku_ctx *c,struct removal *f){
+  sudoku_set(c,f->k/SIZE,f->k%SIZE,f->val);
+  if(f->k!=N_GRIDS-1-f->k)
+    sudoku_set(c,SIZE-1-f->k/SIZE,SIZE-1-f->k%SIZE,f->sym);
+}
+
+// Generate more empty grids of puzzles found in simulating process
+// Their number of empty grids >= min_empty
+// So the odds of finding a puzzle with limit_empty number of empty grids
+// by removing numbers from them are fairly high.
+// The state initialized for the parent puzzle is kept: a removal only
+// unsets two grids (sudoku_unset()) and is reversed with sudoku_set().
+// Depth first on an explicit stack: a frame is pushed for every unique
+// puzzle found and holds the pair removed to get it.
+static void generate(sudoku_ctx *c,int n_empty){
+  struct removal stack[N_PAIRS+CENTRE],*f;
+  int i,j,k=0,depth=0;
+
+  while(!done(c)){
+    // grids k and N_GRIDS-1-k, up to the centre
+    for(; k<=(N_GRIDS-1)/2 && c->sudoku[k/SIZE][k%SIZE]==EMPTY; ++k);
+    if(k<=(N_GRIDS-1)/2){
+      i=k/SIZE;
+      j=k%SIZE;
+      // remove numbers from (i,j) and (SIZE-1-i,SIZE-1-j)
+      f=&stack[depth];
+      f->k=k;
+      f->val=c->sudoku[i][j];
+      f->sym=c->sudoku[SIZE-1-i][SIZE-1-j];
+      sudoku_unset(c,i,j);
+      sudoku_unset(c,SIZE-1-i,SIZE-1-j);
+      STAT(c,removals);
+      if(unique(c,0)){
+	STAT(c,removals_unique);
+	// generate more from this one
+	n_empty+=k==N_GRIDS-1-k ? 1 : 2;
+	improve(c,n_empty);
+	++depth;
+	k=0;
+      }
+      else{
+	restore(c,f);   // reverse lastest change
+	++k;
+      }
+    }
+    else if(depth){
+      // every pair is tried: back to the parent puzzle
+      f=&stack[--depth];
+      restore(c,f);
+      n_empty-=f->k==N_GRIDS-1-f->k ? 1 : 2;
+      k=f->k+1;
+    }
+    else
+      return;
+  }
+  while(depth)
+    restore(c,&stack[--depth]);
+}
+
+static void *generate_thread(void *arg){
+  sudoku_generate(arg);
+  return NULL;
+}
+
+/* Create a puzzle with c->n_threads threads.
+   Every thread has its own context, runs its share of c->trials and
+   draws from its own random stream (c->seed, stream i).
+   The best number of empty grids is shared through a sudoku_best.
+   Better puzzles are published to c (c->improved) as they are found.
+   The result is the first puzzle with limit_empty empty grids in the
+   order of the trials (struct sudoku_best), or else the best one of the
+   lowest thread: the same seed and number of threads give the same
+   result, unless time_limit, deadline, max_checks or a cancel stops it.
+   With c->checkpoint, the state of every thread is saved every
+   c->checkpoint_interval seconds and when the generation stops; after
+   sudoku_resume() the generation goes on from a checkpoint.*/
+int sudoku_generate_parallel(sudoku_ctx *c){
+  struct sudoku_best best;
+  sudoku_ctx **ctx;
+  pthread_t *thread;
+  int *started;
+  long long deadline=c->deadline;
+  int resumed=c->states!=NULL;   // by sudoku_resume()
+  long checks=resumed ? c->n_checks : 0;
+  int i,max,n=resumed ? c->n_states : sudoku_threads(c);
+
+  if(n==1 && !c->checkpoint && !resumed)
+    return sudoku_generate(c);
+  ctx=calloc(n,sizeof(sudoku_ctx *));
+  thread=calloc(n,sizeof(pthread_t));
+  started=calloc(n,sizeof(int));
+  if(!ctx || !thread || !started){
+    free(ctx);
+    free(thread);
+    free(started);
+    return sudoku_generate(c);
+  }
+
+  if(c->checkpoint && !resumed && (c->states=calloc(n,sizeof(struct sudoku_state))))
+    c->n_states=n;
+  if(!resumed){
+    c->max_empty=0;   // nothing found yet: the result is the solution
+    sudoku_copy(c->result,c->sudoku);
+  }
+  max=c->max_empty;
+  atomic_init(&best.max_empty,max);
+  atomic_init(&best.hit,LLONG_MAX);
+  best.n_threads=n;
+  atomic_init(&best.checks,checks);
+  best.parent=c;
+  pthread_mutex_init(&best.lock,NULL);
+  best.next_checkpoint=sudoku_now()+c->checkpoint_interval*1000000000LL;
+  if(c->time_limit && !c->deadline)
+    c->deadline=sudoku_now()+c->time_limit*1000000000LL;   // the same for every thread
+  for(i=0; i<n; ++i){
+    if(!(ctx[i]=sudoku_new()))
+      continue;
+    sudoku_settings(ctx[i],c);
+    sudoku_copy(ctx[i]->sudoku,c->sudoku);
+    ctx[i]->trials=c->trials/n+(i<c->trials%n);
+    ctx[i]->stream=i;
+    ctx[i]->best=&best;
+    if(resumed){
+      memcpy(ctx[i]->rng,c->states[i].rng,sizeof(c->rng));
+      ctx[i]->trials_done=c->states[i].done;
+    }
+    started[i]=!pthread_create(&thread[i],NULL,generate_thread,ctx[i]);
+  }
+
+  c->cache_hits=c->cache_misses=0;
+  c->n_checks=checks;
+  for(i=0; i<n; ++i){
+    if(started[i])
+      pthread_join(thread[i],NULL);
+    if(!ctx[i])
+      continue;
+    if(started[i] && (atomic_load(&best.hit)<LLONG_MAX ?
+		      i==atomic_load(&best.hit)%n : ctx[i]->max_empty>max)){
+      max=ctx[i]->max_empty;
+      sudoku_copy(c->result,ctx[i]->result);
+    }
+    c->n_checks+=ctx[i]->n_checks;
+    c->cache_hits+=ctx[i]->cache_hits;
+    c->cache_misses+=ctx[i]->cache_misses;
+    sudoku_stats_add(&c->stats,&ctx[i]->stats);
+    sudoku_timing_add(c,ctx[i],i);
+    sudoku_delete(ctx[i]);
+  }
+  c->max_empty=max;
+  c->deadline=deadline;
+  if(c->checkpoint && c->states)
+    sudoku_write_checkpoint(c,c->n_checks);   // where the generation stopped
+  free(c->states);
+  c->states=NULL;
+  c->n_states=0;
+  pthread_mutex_destroy(&best.lock);
+  free(ctx);
+  free(thread);
+  free(started);
+  return c->max_empty;
+}
@@ -0,0 +1,314 @@
+/*Project: Sudoku Creator
+  Description: In-Out functions of libsudoku*/
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include"sudoku.h"
+
+#define BLANK(ch) ((ch)==' ' || (ch)=='\t' || (ch)=='\r')
+
+/* Value of a character of a puzzle: its place in SYMBOLS (any case),
+   '0', '.' and others are EMPTY*/
+static int cell(char ch){
+  const char *p;
+  if(ch>='a' && ch<='z')
+    ch+='A'-'a';
+  if(ch=='\0' || !(p=memchr(SYMBOLS,ch,SIZE)))
+    return EMPTY;
+  return p-SYMBOLS;
+}
+
+/* Get sudoku puzzle from a file*/
+// A puzzle is SIZE lines of SIZE symbols or one line of SIZE*SIZE symbols.
+// Blank lines are skipped, so a file may hold many puzzles.
+// Return 0 if the file ends before the puzzle is read.
+int sudoku_read(FILE *fp,int table[][SIZE]){
+  char line[4*SIZE*SIZE];
+  const char *s;
+  int row,col,len;
+  for(row=0; row<SIZE; ++row){
+    do{
+      if(!fgets(line,sizeof(line),fp))
+	return 0;
+      s=line+strspn(line," \t\r");
+      len=strcspn(s," \t\r\n");
+    }while(!len);
+    if(row==0 && len>=SIZE*SIZE){
+      for(col=0; col<SIZE*SIZE; ++col)
+	table[col/SIZE][col%SIZE]=cell(s[col]);
+      return 1;
+    }
+    for(col=0; col<SIZE; ++col){
+      table[row][col]=col<len ? cell(s[col]) : EMPTY;
+    }
+  }
+  return 1;
+}
+
+/* Get a puzzle from one word of SIZE*SIZE symbols at the start of s*/
+// Blanks before it are skipped. Return the number of characters read,
+// 0 if the word is too short.
+int sudoku_scan(const char *s,int table[][SIZE]){
+  const char *p=s;
+  int k;
+  while(BLANK(*p))
+    ++p;
+  for(k=0; k<SIZE*SIZE; ++k)
+    if(!p[k] || BLANK(p[k]) || p[k]=='\n')
+      return 0;
+  for(k=0; k<SIZE*SIZE; ++k)
+    table[k/SIZE][k%SIZE]=cell(p[k]);
+  return p-s+SIZE*SIZE;
+}
+
+/* Add every puzzle of buf[0..len) to *jobs*/
+// Same format as sudoku_read(), parsed in place: no copy, no stdio.
+// *jobs holds *n jobs and has room for *max, it grows as needed.
+// Return the number of puzzles added, -1 if out of memory.
+int sudoku_parse(const char *buf,size_t len,sudoku_job **jobs,int *n,int *max){
+  const char *end=buf+len,*s,*e;
+  signed char *grid=NULL;
+  sudoku_job *p;
+  int row=0,col,k,n0=*n;
+
+  for(; buf<end; buf=e+(e<end)){
+    if(!(e=memchr(buf,'\n',end-buf)))
+      e=end;
+    for(s=buf; s<e && BLANK(*s); ++s);
+    for(k=0; s+k<e && !BLANK(s[k]); ++k);
+    if(!k)
+      continue;    // blank line
+    if(row==0){    // a new puzzle
+      if(*n==*max){
+	if(!(p=realloc(*jobs,(*max ? 2*(size_t)*max : 1024)*sizeof(sudoku_job))))
+	  return -1;
+	*jobs=p;
+	*max=*max ? 2**max : 1024;
+      }
+      grid=(*jobs)[*n].grid;
+    }
+    if(row==0 && k>=SIZE*SIZE){
+      for(col=0; col<SIZE*SIZE; ++col)
+	grid[col]=cell(s[col]);
+      row=SIZE;
+    }
+    else{
+      for(col=0; col<SIZE; ++col)
+	grid[row*SIZE+col]=col<k ? cell(s[col]) : EMPTY;
+      ++row;
+    }
+    if(row==SIZE){
+      row=0;
+      ++*n;
+    }
+  }
+  return *n-n0;
+}
+
+/* Add every puzzle of a file to *jobs, the file is memory-mapped*/
+// Return the number of puzzles added, -1 if the file can't be mapped
+// (not a regular file,...) or out of memory.
+int sudoku_map(const char *path,sudoku_job **jobs,int *n,int *max){
+  struct stat st;
+  void *buf;
+  int fd,ret;
+
+  if((fd=open(path,O_RDONLY))<0)
+    return -1;
+  if(fstat(fd,&st)<0 || !S_ISREG(st.st_mode)){
+    close(fd);
+    return -1;
+  }
+  if(st.st_size==0){
+    close(fd);
+    return 0;
+  }
+  buf=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(buf==MAP_FAILED)
+    return -1;
+  madvise(buf,st.st_size,MADV_SEQUENTIAL);
+  ret=sudoku_parse(buf,st.st_size,jobs,n,max);
+  munmap(buf,st.st_size);
+  return ret;
+}
+
+/* Print a table*/
+// The table is formatted in a buffer and written at once.
+void sudoku_print(int table[][SIZE],FILE *fp){
+  char buf[SIZE*(2*SIZE+1)+1],*p=buf;
+  int row,col;
+  for(row=0; row<SIZE; ++row){
+    for(col=0; col<SIZE; ++col){
+      *p++=table[row][col]>=0 ? SYMBOLS[table[row][col]] : '*';
+      *p++=' ';
+    }
+    *p++='\n';
+  }
+  *p++='\n';
+  fwrite(buf,1,p-buf,fp);
+}
+
+/* Save table*/
+void sudoku_save(int table[][SIZE],FILE *fp){
+  char buf[SIZE*(SIZE+1)+1],*p=buf;
+  int row,col;
+  for(row=0; row<SIZE; ++row){
+    for(col=0; col<SIZE; ++col){
+      *p++=table[row][col]>=0 ? SYMBOLS[table[row][col]] : '0';
+    }
+    *p++='\n';
+  }
+  *p++='\n';
+  fwrite(buf,1,p-buf,fp);
+}
+
+/* Copy two tables*/
+void sudoku_copy(int to[][SIZE],int from[][SIZE]){
+  int row,col;
+  for(row=0; row<SIZE; ++row){
+    for(col=0; col<SIZE; ++col){
+      to[row][col]=from[row][col];
+    }
+  }
+}
+
+/* Pack a table: grid k is bits k*CELL_BITS.. of buf (low bits first),
+   value+1 or 0 for EMPTY. With SIZE 9 grid k is the nibble k%2 of buf[k/2].*/
+void sudoku_pack(int table[][SIZE],unsigned char *buf){
+  int k,i,bit,v;
+  memset(buf,0,SUDOKU_PACKED);
+  for(k=0,bit=0; k<SIZE*SIZE; ++k){
+    v=table[k/SIZE][k%SIZE]+1;
+    for(i=0; i<CELL_BITS; ++i,++bit)
+      buf[bit/8]|=(v>>i&1)<<(bit%8);
+  }
+}
+
+void sudoku_unpack(const unsigned char *buf,int table[][SIZE]){
+  int k,i,bit,v;
+  for(k=0,bit=0; k<SIZE*SIZE; ++k){
+    for(v=0,i=0; i<CELL_BITS; ++i,++bit)
+      v|=(buf[bit/8]>>(bit%8)&1)<<i;
+    table[k/SIZE][k%SIZE]=v>=1 && v<=SIZE ? v-1 : EMPTY;
+  }
+}
+
+/* Rank a complete solution.
+   Rows 0..SIZE-2 are permutations, stored as their rank (Lehmer code)
+   in RANK_BITS bits each. The last row is the value missing in every
+   column, so it is not stored.
+   Return 0 if the table is not a complete solution, or if SIZE! doesn't
+   fit in 64 bits (RANK_BITS 0).*/
+int sudoku_rank(int table[][SIZE],unsigned char *buf){
+  unsigned int used,col_used[SIZE]={0};
+  unsigned long long rank;
+  int row,col,v,i,bit=0;
+
+  if(!RANK_BITS)
+    return 0;
+  memset(buf,0,SUDOKU_RANKED);
+  for(row=0; row<SIZE; ++row){
+    used=0;
+    rank=0;
+    for(col=0; col<SIZE; ++col){
+      v=table[row][col];
+      if(v<0 || v>=SIZE || (used|col_used[col])>>v&1)
+	return 0;
+      // number of unused values smaller than v, in base SIZE-col
+      rank=rank*(SIZE-col)+v-__builtin_popcount(used&((1u<<v)-1));
+      used|=1u<<v;
+      col_used[col]|=1u<<v;
+    }
+    if(row<SIZE-1)
+      for(i=0; i<RANK_BITS; ++i,++bit)
+	buf[bit/8]|=(rank>>i&1)<<(bit%8);
+  }
+  return 1;
+}
+
+int sudoku_unrank(const unsigned char *buf,int table[][SIZE]){
+  unsigned int unused,m,col_used[SIZE]={0};
+  unsigned long long rank,f;
+  int row,col,v,i,bit;
+
+  if(!RANK_BITS)
+    return 0;
+  for(row=0; row<SIZE-1; ++row){
+    rank=0;
+    for(i=0,bit=row*RANK_BITS; i<RANK_BITS; ++i,++bit)
+      rank|=(unsigned long long)(buf[bit/8]>>(bit%8)&1)<<i;
+    unused=ALL_VALUES;
+    for(f=1,i=2; i<SIZE; ++i)
+      f*=i;   // f=(SIZE-1-col)! for col=0
+    for(col=0; col<SIZE; ++col){
+      i=rank/f;
+      rank%=f;
+      if(col<SIZE-1)
+	f/=SIZE-1-col;
+      if(i>=__builtin_popcount(unused))
+	return 0;
+      // the i-th unused value
+      for(m=unused; i--; m&=m-1);
+      v=__builtin_ctz(m);
+      unused&=~(1u<<v);
+      table[row][col]=v;
+      if(col_used[col]>>v&1)
+	return 0;
+      col_used[col]|=1u<<v;
+    }
+  }
+  for(col=0; col<SIZE; ++col)
+    table[SIZE-1][col]=__builtin_ctz(~col_used[col]&ALL_VALUES);
+  return 1;
+}
+
+/* Save a table in a format (FORMAT_TEXT,...)*/
+// FORMAT_RANKED needs a complete solution.
+int sudoku_write(int table[][SIZE],FILE *fp,int format){
+  unsigned char buf[SUDOKU_PACKED];
+  switch(format){
+  case FORMAT_PACKED:
+    sudoku_pack(table,buf);
+    return fwrite(buf,SUDOKU_PACKED,1,fp)==1;
+  case FORMAT_RANKED:
+    return sudoku_rank(table,buf) && fwrite(buf,SUDOKU_RANKED,1,fp)==1;
+  default:
+    sudoku_save(table,fp);
+    return !ferror(fp);
+  }
+}
+
+/* Get a table written by sudoku_write()*/
+int sudoku_load(FILE *fp,int table[][SIZE],int format){
+  unsigned char buf[SUDOKU_PACKED];
+  switch(format){
+  case FORMAT_PACKED:
+    if(fread(buf,SUDOKU_PACKED,1,fp)!=1)
+      return 0;
+    sudoku_unpack(buf,table);
+    return 1;
+  case FORMAT_RANKED:
+    return fread(buf,SUDOKU_RANKED,1,fp)==1 && sudoku_unrank(buf,table);
+  default:
+    return sudoku_read(fp,table);
+  }
+}
+
+/* Number of empty grids in a table*/
+int sudoku_empty(int table[][SIZE]){
+  int i,j,cnt;
+  cnt=0;
+  for(i=0; i<SIZE; ++i){
+    for(j=0; j<SIZE; ++j){
+      if(table[i][j]==EMPTY)
+	++cnt;
+    }
+  }
+  return cnt;
+}
@@ -0,0 +1,133 @@
+/*Project: Sudoku Creator
+  Description: Solve many puzzles in lockstep (libsudoku, --lockstep).
+  The candidates of SUDOKU_LANES puzzles are held in vectors: lane l of
+  cand[k] is the mask of grid k of puzzle l. Naked and hidden singles
+  are propagated for all the puzzles at once with GCC vector
+  extensions; on x86-64 the kernel is built for AVX2 and for the
+  default target (SSE2) and the best one is picked at run time, other
+  targets get scalar code.
+  Every deduction holds for every solution, so a puzzle filled by
+  propagation alone has exactly that solution. Only the other puzzles
+  are searched, one at a time, by sudoku_solve_from() starting from
+  the grids deduced.*/
+
+#include<string.h>
+#include"sudoku.h"
+
+#define N_GRIDS (SIZE*SIZE)
+#define N_UNITS (3*SIZE)    // rows, columns and blocks
+
+typedef sudoku_bits lanes __attribute__((vector_size(SUDOKU_LANES*sizeof(sudoku_bits))));
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define KERNEL __attribute__((target_clones("avx2","default")))
+#else
+#define KERNEL
+#endif
+
+/* Grids of every unit*/
+static void make_units(unsigned short unit[][SIZE]){
+  int u,i;
+  for(u=0; u<SIZE; ++u)
+    for(i=0; i<SIZE; ++i){
+      unit[u][i]=u*SIZE+i;                 // row u
+      unit[SIZE+u][i]=i*SIZE+u;            // column u
+      unit[2*SIZE+u][i]=(u/(SIZE/BOX_W)*BOX_H+i/BOX_W)*SIZE
+	+u%(SIZE/BOX_W)*BOX_W+i%BOX_W;     // block u
+    }
+}
+
+/* Some lane of *v is not 0*/
+static inline int any(const lanes *v){
+  sudoku_bits m=0;
+  int l;
+  for(l=0; l<SUDOKU_LANES; ++l)
+    m|=(*v)[l];
+  return m!=0;
+}
+
+/* Propagate naked and hidden singles in every lane until nothing changes.
+   Lane l of *result is not 0 if puzzle l has a contradiction.*/
+// Vectors are passed by pointer: the clones don't share a vector ABI.
+KERNEL static void propagate(lanes *cand,unsigned short unit[][SIZE],lanes *result){
+  lanes m,n,s,h,single,seen,dup,once,twice,hidden,changed,bad,go;
+  const lanes zero={0},all=zero+ALL_VALUES;
+  int u,i;
+
+  bad=zero;
+  do{
+    changed=zero;
+    for(u=0; u<N_UNITS; ++u){
+      seen=dup=once=twice=zero;
+      for(i=0; i<SIZE; ++i){
+	m=cand[unit[u][i]];
+	s=m&(lanes)((m&(m-1))==0);   // the value of a single, else 0
+	dup|=seen&s;
+	seen|=s;
+	twice|=once&m;
+	once|=m;
+      }
+      bad|=dup|(once^all);   // a value twice or nowhere
+      hidden=once&~twice&~seen;
+      for(i=0; i<SIZE; ++i){
+	m=cand[unit[u][i]];
+	single=(lanes)((m&(m-1))==0);
+	n=(m&single)|(m&~seen&~single);   // naked singles of the unit
+	h=n&hidden;                        // hidden singles
+	bad|=h&(h-1);
+	s=(lanes)(h!=0);
+	n=(h&s)|(n&~s);
+	bad|=(lanes)(n==0);
+	changed|=n^m;
+	cand[unit[u][i]]=n;
+      }
+    }
+    go=changed&~bad;
+  }while(any(&go));
+  *result=bad;
+}
+
+/* Solve n jobs, SUDOKU_LANES at a time*/
+// Same statuses and solutions as sudoku_solve_job() on every job.
+void sudoku_solve_lanes(sudoku_ctx *c,sudoku_job *jobs,int n){
+  lanes cand[N_GRIDS],bad;
+  unsigned short unit[N_UNITS][SIZE];
+  signed char deduced[N_GRIDS];
+  sudoku_bits m;
+  int l,k,g,solved;
+
+  make_units(unit);
+  for(; n>0; jobs+=SUDOKU_LANES,n-=SUDOKU_LANES){
+    for(k=0; k<N_GRIDS; ++k)
+      for(l=0; l<SUDOKU_LANES; ++l){
+	g=l<n ? jobs[l].grid[k] : EMPTY;
+	cand[k][l]=g==EMPTY ? ALL_VALUES : 1u<<g;
+      }
+    propagate(cand,unit,&bad);
+
+    for(l=0; l<SUDOKU_LANES && l<n; ++l){
+      if(bad[l]){
+	// no solution, or conflicting numbers: let the solver tell
+	sudoku_solve_job(c,&jobs[l]);
+	continue;
+      }
+      solved=1;
+      for(k=0; k<N_GRIDS; ++k){
+	m=cand[k][l];
+	if(m&(m-1)){
+	  deduced[k]=EMPTY;
+	  solved=0;
+	}
+	else
+	  deduced[k]=__builtin_ctz(m);
+      }
+      if(solved){
+	STAT(c,lockstep);
+	memcpy(jobs[l].solution,deduced,N_GRIDS);
+	jobs[l].status=JOB_SOLVED;
+      }
+      else
+	sudoku_solve_from(c,&jobs[l],deduced);   // search from the numbers found
+    }
+  }
+}
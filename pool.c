@@ -0,0 +1,166 @@
+/*Project: Sudoku Creator
+  Description: Solve many puzzles on all cores (libsudoku).
+  Every worker owns a context and a range of jobs. A worker takes jobs
+  from the front of its range; when its range is empty it steals the
+  back half of the range of another worker.*/
+
+#include<stdlib.h>
+#include<string.h>
+#include<pthread.h>
+#include"sudoku.h"
+
+struct worker{
+  pthread_mutex_t lock;
+  int begin,end;           // jobs [begin,end) not taken yet
+  pthread_t thread;
+  int started;             // thread is running
+  sudoku_ctx *ctx;
+  struct pool *pool;
+};
+
+struct pool{
+  struct worker *workers;
+  int n_workers;
+  sudoku_job *jobs;
+};
+
+/* Take the first n jobs (or fewer) of worker w: jobs [*i,*i+return)*/
+// Return 0 if there is none.
+static int take(struct worker *w,int n,int *i){
+  pthread_mutex_lock(&w->lock);
+  if(n>w->end-w->begin)
+    n=w->end-w->begin;
+  *i=w->begin;
+  w->begin+=n;
+  pthread_mutex_unlock(&w->lock);
+  return n;
+}
+
+/* Move the back half of the jobs of another worker to worker w.
+   Return 0 if every worker has run out of jobs.*/
+static int steal(struct worker *w){
+  struct pool *p=w->pool;
+  struct worker *v;
+  int i,n,begin,end;
+
+  for(i=1; i<p->n_workers; ++i){
+    v=&p->workers[(w-p->workers+i)%p->n_workers];
+    pthread_mutex_lock(&v->lock);
+    n=(v->end-v->begin+1)/2;
+    end=v->end;
+    begin=end-n;
+    v->end=begin;
+    pthread_mutex_unlock(&v->lock);
+    if(n>0){
+      pthread_mutex_lock(&w->lock);
+      w->begin=begin;
+      w->end=end;
+      pthread_mutex_unlock(&w->lock);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Keep the first solution of the job being solved*/
+static void keep_solution(sudoku_ctx *c){
+  sudoku_job *job=c->user;
+  int table[SIZE][SIZE];
+  int row,col;
+  if(c->n_ans>1)
+    return;
+  sudoku_solution(c,table);
+  for(row=0; row<SIZE; ++row)
+    for(col=0; col<SIZE; ++col)
+      job->solution[row*SIZE+col]=table[row][col];
+}
+
+/* Solve one job with context c*/
+void sudoku_solve_job(sudoku_ctx *c,sudoku_job *job){
+  sudoku_solve_from(c,job,NULL);
+}
+
+/* Solve one job from the grids deduced from its numbers (or NULL)*/
+// Same status and solution as sudoku_solve_job(): see sudoku_init_deduced().
+void sudoku_solve_from(sudoku_ctx *c,sudoku_job *job,const signed char *deduced){
+  int row,col;
+
+  for(row=0; row<SIZE; ++row)
+    for(col=0; col<SIZE; ++col)
+      c->sudoku[row][col]=job->grid[row*SIZE+col];
+  c->user=job;
+  c->solution_found=keep_solution;
+  c->max_ans=2;    // "more than one" is enough
+  c->n_ans=0;
+  if(sudoku_init_deduced(c,deduced)>=0){
+    job->status=JOB_INVALID;
+    return;
+  }
+  sudoku_search(c);
+  job->status=c->n_ans==0 ? JOB_NONE : c->n_ans==1 ? JOB_SOLVED : JOB_MULTIPLE;
+}
+
+static void *work(void *arg){
+  struct worker *w=arg;
+  int i,n;
+  do{
+    if(w->ctx->lockstep)
+      while((n=take(w,SUDOKU_LANES,&i))>0)
+	sudoku_solve_lanes(w->ctx,&w->pool->jobs[i],n);
+    else
+      while(take(w,1,&i))
+	sudoku_solve_job(w->ctx,&w->pool->jobs[i]);
+  }while(steal(w));
+  return NULL;
+}
+
+/* Solve n jobs with n_threads workers (0: c->n_threads).
+   Every worker copies the solver settings of c.
+   Return 0 if the workers can't be started.*/
+int sudoku_batch(sudoku_ctx *c,sudoku_job *jobs,int n,int n_threads){
+  struct pool p;
+  struct worker *w;
+  int i,ok=1;
+
+  if(n_threads<=0)
+    n_threads=sudoku_threads(c);
+  if(n_threads>n)
+    n_threads=n>0 ? n : 1;
+
+  p.jobs=jobs;
+  p.n_workers=n_threads;
+  if(!(p.workers=calloc(n_threads,sizeof(struct worker))))
+    return 0;
+  for(i=0; i<n_threads; ++i){
+    w=&p.workers[i];
+    pthread_mutex_init(&w->lock,NULL);
+    w->begin=(long)n*i/n_threads;
+    w->end=(long)n*(i+1)/n_threads;
+    w->pool=&p;
+    if(!(w->ctx=sudoku_new()))
+      ok=0;
+    else
+      sudoku_settings(w->ctx,c);
+  }
+  /* Worker 0 runs in the calling thread*/
+  // If a thread can't be started, its jobs are stolen by the others.
+  for(i=1; ok && i<n_threads; ++i){
+    w=&p.workers[i];
+    w->started=!pthread_create(&w->thread,NULL,work,w);
+  }
+  if(ok)
+    work(&p.workers[0]);
+  for(i=0; i<n_threads; ++i){
+    w=&p.workers[i];
+    if(w->started)
+      pthread_join(w->thread,NULL);
+    pthread_mutex_destroy(&w->lock);
+    if(w->ctx){
+      sudoku_stats_add(&c->stats,&w->ctx->stats);
+      sudoku_timing_add(c,w->ctx,i);
+    }
+    sudoku_delete(w->ctx);
+  }
+  free(p.workers);
+  return ok;
+}
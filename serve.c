@@ -0,0 +1,424 @@
+/*Project: Sudoku Creator
+  Description: Solver daemon.
+  Requests are lines read from the standard input (answers are written
+  on the standard output) or, with --socket=PATH, from every client of
+  a Unix domain socket:
+    <id> solve <puzzle>         -> <id> solved|multiple <solution>
+                                   <id> none, <id> invalid
+    <id> count <puzzle> [limit] -> <id> count <n>  (n=limit: limit or more)
+                                   limit 1..MAX_COUNT, MAX_COUNT by default;
+                                   <id> error too many solutions if a
+                                   count without limit reaches MAX_COUNT
+    <id> unique <puzzle>        -> <id> unique 1|0
+    <id> generate <solution> [min_empty [trials]]
+                                -> <id> generated <empty grids> <puzzle>
+  A puzzle is one word of SIZE*SIZE symbols ('0' or '.' is empty).
+  Other requests are answered with <id> error <reason>.
+  Requests are queued and answered by a pool of workers whose contexts
+  are made once at start. Answers may come out of order: a client
+  matches them by id, so it can send many requests without waiting.
+  Workers never read from or write to a client: answers go into the
+  buffer of the client and a writer thread per client sends them. A
+  client has at most MAX_PENDING requests in flight (read but not
+  written back); then its requests are no longer read until it reads
+  its answers, so a slow client only slows itself down.*/
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<signal.h>
+#include<time.h>
+#include<unistd.h>
+#include<pthread.h>
+#include<sys/socket.h>
+#include<sys/un.h>
+#include"sudoku.h"
+
+#define MAX_LINE 1024     // longer requests are refused
+#define MAX_QUEUE 1024    // requests waiting for a worker
+#define MAX_PENDING 64    // requests in flight of a client
+#define MAX_ID 32
+#define MAX_COUNT 100000  // count: solutions at most (a worker is busy 0.3 s)
+#define MAX_ANSWER (MAX_ID+32+SIZE*SIZE)
+#define TRIALS 1000       // generate: samples by default
+#define LIMIT_TIME 20     // generate: seconds at most
+#define MIN SCALE(49)     // generate: empty grids by default
+#define MAX_SAMPLE SCALE(54)
+
+/* A client: requests are read from in, answers written to out*/
+struct client{
+  int in,out;
+  int socket;              // closed when it is done
+  pthread_t writer;
+  pthread_mutex_t lock;    // never held during a read or a write
+  pthread_cond_t ready;    // answers to write, or no more requests
+  pthread_cond_t room;     // fewer than MAX_PENDING requests in flight
+  int pending;             // requests read but not written back
+  int done;                // no more requests
+  int n_answers,len;       // answers in buf and their length
+  char buf[MAX_PENDING*MAX_ANSWER];
+};
+
+struct request{
+  struct client *client;
+  char line[MAX_LINE];
+};
+
+struct worker{
+  pthread_t thread;
+  sudoku_ctx *ctx;
+};
+
+/* Variables*/
+sudoku_ctx *ctx;
+struct worker *workers;
+int n_workers;
+struct request queue[MAX_QUEUE];
+int head,n_queued;
+pthread_mutex_t queue_lock=PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t not_empty=PTHREAD_COND_INITIALIZER,not_full=PTHREAD_COND_INITIALIZER;
+
+const char *status_name[]={"solved","multiple","none","invalid"};
+
+/*Functions*/
+void *work(void *arg);
+struct client *new_client(int in,int out,int socket);
+void *read_requests(void *arg);   /* queue the requests of a client*/
+void *write_answers(void *arg);   /* send the answers of a client*/
+void reserve(struct client *cl);
+void submit(struct client *cl,const char *line);
+void reply(struct client *cl,const char *buf,int len);
+int answer(sudoku_ctx *c,const char *line,char *buf);
+int complete(int table[][SIZE]);
+void serve_socket(const char *path);
+
+/****************MAIN************/
+int main(int argc, char **argv){
+  struct client *cl;
+  const char *path=NULL;
+  int i;
+
+  ctx=sudoku_new();
+  ctx->seed=time(NULL);
+  for(i=1; i<argc; ++i){
+    if(!strncmp(argv[i],"--socket=",9))
+      path=argv[i]+9;
+    else if(!sudoku_option(ctx,argv[i])){
+      fprintf(stderr,"Unknown option %s\n",argv[i]);
+      exit(1);
+    }
+  }
+  signal(SIGPIPE,SIG_IGN);   // a client may leave before its answers
+
+  /* Warm contexts: one per worker*/
+  n_workers=sudoku_threads(ctx);
+  if(!(workers=calloc(n_workers,sizeof(struct worker)))){
+    fprintf(stderr,"Out of memory.\n");
+    exit(1);
+  }
+  for(i=0; i<n_workers; ++i){
+    if(!(workers[i].ctx=sudoku_new())){
+      fprintf(stderr,"Out of memory.\n");
+      exit(1);
+    }
+    sudoku_settings(workers[i].ctx,ctx);
+    workers[i].ctx->stream=i;
+    if(pthread_create(&workers[i].thread,NULL,work,workers[i].ctx)){
+      fprintf(stderr,"Can't start the workers.\n");
+      exit(1);
+    }
+  }
+
+  if(path)
+    serve_socket(path);
+  /* Standard input: stop when every request is answered*/
+  if(!(cl=new_client(0,1,0))){
+    fprintf(stderr,"Out of memory.\n");
+    exit(1);
+  }
+  read_requests(cl);
+  for(i=0; i<n_workers; ++i){
+    sudoku_stats_add(&ctx->stats,&workers[i].ctx->stats);
+    sudoku_timing_add(ctx,workers[i].ctx,i);
+  }
+  if(ctx->stats_format)
+    sudoku_print_stats(ctx,stderr);
+  if(ctx->timing)
+    sudoku_print_timing(ctx,stderr);
+  if(ctx->trace_file && !sudoku_write_trace(ctx,ctx->trace_file))
+    fprintf(stderr,"Can't write %s\n",ctx->trace_file);
+  return 0;
+}
+/****************MAIN************/
+/* Accept clients on a Unix domain socket, forever*/
+void serve_socket(const char *path){
+  struct sockaddr_un addr;
+  struct client *cl;
+  pthread_t thread;
+  int fd,s;
+
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family=AF_UNIX;
+  if(strlen(path)>=sizeof(addr.sun_path)){
+    fprintf(stderr,"Socket path too long: %s\n",path);
+    exit(1);
+  }
+  strcpy(addr.sun_path,path);
+  unlink(path);
+  if((fd=socket(AF_UNIX,SOCK_STREAM,0))<0 ||
+     bind(fd,(struct sockaddr *)&addr,sizeof(addr))<0 || listen(fd,64)<0){
+    perror(path);
+    exit(1);
+  }
+  fprintf(stderr,"Listening on %s\n",path);
+  for(;;){
+    if((s=accept(fd,NULL,NULL))<0)
+      continue;
+    if(!(cl=new_client(s,s,1))){
+      close(s);
+      continue;
+    }
+    if(pthread_create(&thread,NULL,read_requests,cl)){
+      cl->in=-1;   // the writer alone closes the socket
+      read_requests(cl);
+      continue;
+    }
+    pthread_detach(thread);
+  }
+}
+
+/* A client with its writer thread (NULL if it can't be started)*/
+struct client *new_client(int in,int out,int socket){
+  struct client *cl=calloc(1,sizeof(struct client));
+  if(!cl)
+    return NULL;
+  cl->in=in;
+  cl->out=out;
+  cl->socket=socket;
+  pthread_mutex_init(&cl->lock,NULL);
+  pthread_cond_init(&cl->ready,NULL);
+  pthread_cond_init(&cl->room,NULL);
+  if(pthread_create(&cl->writer,NULL,write_answers,cl)){
+    pthread_mutex_destroy(&cl->lock);
+    pthread_cond_destroy(&cl->ready);
+    pthread_cond_destroy(&cl->room);
+    free(cl);
+    return NULL;
+  }
+  return cl;
+}
+
+/* Read the requests of a client and queue them*/
+// When the client has no more requests and every answer is written,
+// the client is closed (unless it is the standard input) and freed.
+void *read_requests(void *arg){
+  struct client *cl=arg;
+  FILE *fp=cl->in<0 ? NULL : cl->socket ? fdopen(cl->in,"r") : stdin;
+  char line[MAX_LINE],buf[MAX_ANSWER],*p;
+  size_t len;
+  int ch,k;
+
+  while(fp && fgets(line,sizeof(line),fp)){
+    len=strlen(line);
+    if(len==sizeof(line)-1 && line[len-1]!='\n'){
+      while((ch=getc(fp))!=EOF && ch!='\n');   // skip the rest
+      p=line+strspn(line," \t");
+      if((k=strcspn(p," \t\r\n"))>MAX_ID-1)
+	k=MAX_ID-1;   // the id
+      reserve(cl);
+      reply(cl,buf,sprintf(buf,"%.*s error request too long\n",k,p));
+      continue;
+    }
+    if(line[strspn(line," \t\r\n")])
+      submit(cl,line);
+  }
+  pthread_mutex_lock(&cl->lock);
+  cl->done=1;
+  pthread_cond_signal(&cl->ready);
+  pthread_mutex_unlock(&cl->lock);
+  pthread_join(cl->writer,NULL);
+  if(cl->socket){
+    if(fp)
+      fclose(fp);
+    else
+      close(cl->out);
+  }
+  pthread_mutex_destroy(&cl->lock);
+  pthread_cond_destroy(&cl->ready);
+  pthread_cond_destroy(&cl->room);
+  free(cl);
+  return NULL;
+}
+
+/* Send the answers of a client as they come, until the client has no
+   more requests and every answer is sent*/
+// The lock is released while writing: workers append behind the bytes
+// being written. Answers to a client that has left are dropped.
+void *write_answers(void *arg){
+  struct client *cl=arg;
+  ssize_t n;
+  int len,k,m,gone=0;
+
+  pthread_mutex_lock(&cl->lock);
+  for(;;){
+    while(!cl->len && !(cl->done && !cl->pending))
+      pthread_cond_wait(&cl->ready,&cl->lock);
+    if(!cl->len)
+      break;
+    len=cl->len;
+    m=cl->n_answers;
+    pthread_mutex_unlock(&cl->lock);
+    for(k=0; !gone && k<len; k+=n)
+      if((n=write(cl->out,cl->buf+k,len-k))<=0)
+	gone=1;
+    pthread_mutex_lock(&cl->lock);
+    memmove(cl->buf,cl->buf+len,cl->len-len);
+    cl->len-=len;
+    cl->n_answers-=m;
+    cl->pending-=m;
+    pthread_cond_signal(&cl->room);
+  }
+  pthread_mutex_unlock(&cl->lock);
+  return NULL;
+}
+
+/* Wait until the client may have one more request in flight*/
+void reserve(struct client *cl){
+  pthread_mutex_lock(&cl->lock);
+  while(cl->pending==MAX_PENDING)
+    pthread_cond_wait(&cl->room,&cl->lock);
+  ++cl->pending;
+  pthread_mutex_unlock(&cl->lock);
+}
+
+/* Queue a request, wait while the client or the queue is full*/
+void submit(struct client *cl,const char *line){
+  struct request *r;
+  reserve(cl);
+  pthread_mutex_lock(&queue_lock);
+  while(n_queued==MAX_QUEUE)
+    pthread_cond_wait(&not_full,&queue_lock);
+  r=&queue[(head+n_queued)%MAX_QUEUE];
+  r->client=cl;
+  strcpy(r->line,line);
+  ++n_queued;
+  pthread_cond_signal(&not_empty);
+  pthread_mutex_unlock(&queue_lock);
+}
+
+/* Answer queued requests with the context of a worker*/
+void *work(void *arg){
+  sudoku_ctx *c=arg;
+  struct client *cl;
+  char line[MAX_LINE],buf[MAX_ANSWER];
+
+  for(;;){
+    pthread_mutex_lock(&queue_lock);
+    while(!n_queued)
+      pthread_cond_wait(&not_empty,&queue_lock);
+    cl=queue[head].client;
+    strcpy(line,queue[head].line);
+    head=(head+1)%MAX_QUEUE;
+    --n_queued;
+    pthread_cond_signal(&not_full);
+    pthread_mutex_unlock(&queue_lock);
+
+    reply(cl,buf,answer(c,line,buf));
+  }
+  return NULL;
+}
+
+/* Hand an answer to the writer of a client*/
+// There is room: the request of the answer was reserved.
+void reply(struct client *cl,const char *buf,int len){
+  pthread_mutex_lock(&cl->lock);
+  memcpy(cl->buf+cl->len,buf,len);
+  cl->len+=len;
+  ++cl->n_answers;
+  pthread_cond_signal(&cl->ready);
+  pthread_mutex_unlock(&cl->lock);
+}
+
+/* Answer a request in buf, return the length of the answer*/
+int answer(sudoku_ctx *c,const char *line,char *buf){
+  int table[SIZE][SIZE];
+  sudoku_job job;
+  char id[MAX_ID],cmd[16],*p,*q;
+  int n,k;
+  long a,b;
+
+  id[0]='\0';
+  if(sscanf(line,"%31s %15s%n",id,cmd,&n)<2)
+    return sprintf(buf,"%.31s error no command\n",id);
+  p=(char *)line+n;
+  if(!(k=sudoku_scan(p,table)))
+    return sprintf(buf,"%s error no puzzle\n",id);
+  p+=k;
+
+  if(!strcmp(cmd,"solve")){
+    for(k=0; k<SIZE*SIZE; ++k)
+      job.grid[k]=table[k/SIZE][k%SIZE];
+    sudoku_solve_job(c,&job);
+    n=sprintf(buf,"%s %s",id,status_name[job.status]);
+    if(job.status==JOB_SOLVED || job.status==JOB_MULTIPLE){
+      buf[n++]=' ';
+      for(k=0; k<SIZE*SIZE; ++k)
+	buf[n++]=SYMBOLS[job.solution[k]];
+    }
+  }
+  else if(!strcmp(cmd,"count")){
+    a=strtol(p,&q,10);
+    if(q==p)
+      a=0;    // no limit: MAX_COUNT
+    else if(a<=0 || a>MAX_COUNT)
+      return sprintf(buf,"%s error limit must be 1..%d\n",id,MAX_COUNT);
+    sudoku_copy(c->sudoku,table);
+    if((k=sudoku_count(c,a ? a : MAX_COUNT))==MAX_COUNT && !a)
+      return sprintf(buf,"%s error too many solutions (%d or more)\n",id,MAX_COUNT);
+    n=sprintf(buf,"%s count %d",id,k);
+  }
+  else if(!strcmp(cmd,"unique")){
+    sudoku_copy(c->sudoku,table);
+    n=sprintf(buf,"%s unique %d",id,sudoku_count(c,2)==1);
+  }
+  else if(!strcmp(cmd,"generate")){
+    if(!complete(table))
+      return sprintf(buf,"%s error not a solution\n",id);
+    a=strtol(p,&p,10);
+    b=strtol(p,NULL,10);
+    if(a<0 || a>=SIZE*SIZE)
+      return sprintf(buf,"%s error bad number of empty grids\n",id);
+    c->min_empty=a ? a : MIN;
+    c->max_sample=c->min_empty<MAX_SAMPLE ? MAX_SAMPLE : c->min_empty+1;
+    c->trials=b>0 ? b : TRIALS;
+    c->time_limit=LIMIT_TIME;
+    c->limit_empty=0;
+    ++c->seed;    // another puzzle every time
+    sudoku_copy(c->sudoku,table);
+    n=sprintf(buf,"%s generated %d ",id,sudoku_generate(c));
+    for(k=0; k<SIZE*SIZE; ++k)
+      buf[n++]=c->result[k/SIZE][k%SIZE]==EMPTY ? '0' : SYMBOLS[c->result[k/SIZE][k%SIZE]];
+  }
+  else
+    return sprintf(buf,"%s error unknown command %s\n",id,cmd);
+  buf[n++]='\n';
+  return n;
+}
+
+/* The table is a complete solution*/
+int complete(int table[][SIZE]){
+  unsigned int rows[SIZE]={0},cols[SIZE]={0},blocks[SIZE]={0},bit;
+  int row,col,b;
+  for(row=0; row<SIZE; ++row)
+    for(col=0; col<SIZE; ++col){
+      if(table[row][col]==EMPTY)
+	return 0;
+      bit=1u<<table[row][col];
+      b=row/BOX_H*(SIZE/BOX_W)+col/BOX_W;
+      if((rows[row]|cols[col]|blocks[b])&bit)
+	return 0;
+      rows[row]|=bit;
+      cols[col]|=bit;
+      blocks[b]|=bit;
+    }
+  return 1;
+}
@@ -0,0 +1,643 @@
+/*Project: Sudoku Creator
+  Description: Solver core of libsudoku.
+  Available states are kept as bit masks, so the candidates of a grid
+  are obtained with a single OR/AND instead of 3*SIZE array loads.
+  The block dimensions BOX_W and BOX_H are fixed at compile time.*/
+
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+#include"sudoku.h"
+
+static void search(sudoku_ctx *c);
+static int propagate(sudoku_ctx *c);
+static void unpropagate(sudoku_ctx *c,int mark);
+static void update(sudoku_ctx *c,int row,int col,int val);
+static void remove_update(sudoku_ctx *c,int row,int col,int val);
+
+/* Order of the values tried in a grid*/
+// Values are tried from last+1 up to SIZE-1, then from 0 up to last:
+// candidates are rotated so that value "last" is the highest bit.
+// Unguided searches use last=SIZE-1, that is the plain order 0..SIZE-1.
+#define LAST_VALUE(c,row,col) ((c)->guided ? (c)->guide[row][col] : SIZE-1)
+#define ROTATE(cand,last) \
+  (((cand)>>((last)+1)|(cand)<<(SIZE-1-(last)))&ALL_VALUES)
+#define VALUE(rotated,last) \
+  ((__builtin_ctz(rotated)+(last)+1)%SIZE)
+
+/* Allocate a context with default settings (sudoku_new())*/
+// size is sizeof(sudoku_ctx) where sudoku.h was compiled: another size
+// means other block dimensions or another version of the library.
+sudoku_ctx *sudoku_new_abi(size_t size){
+  sudoku_ctx *c;
+  if(size!=sizeof(sudoku_ctx) || !(c=calloc(1,sizeof(sudoku_ctx))))
+    return NULL;
+  c->engine=ENGINE_BACKTRACK;
+  c->search_order=ORDER_FIXED;
+  c->propagation=1;
+  c->seed=1;
+  c->cache_size=1<<16;
+  c->checkpoint_interval=60;
+  return c;
+}
+
+/* SIZE of this library*/
+int sudoku_size(void){
+  return SIZE;
+}
+
+void sudoku_delete(sudoku_ctx *c){
+  if(!c)
+    return;
+  sudoku_dlx_free(c);
+  sudoku_unavoidable_free(c);
+  sudoku_cache_free(c);
+  sudoku_timing_free(c);
+  free(c->states);
+  free(c);
+}
+
+/* Apply a command line option of the solver
+   --mrv : put numbers into the most constrained grid first
+   --no-propagate : search without naked/hidden singles
+   --dlx : search with Dancing Links instead of backtracking
+   --lockstep : sudoku_batch() propagates many puzzles at once first
+   --threads=N : use N threads (0: one per core)
+   --packed, --ranked : write (and read) tables in a binary format
+   --cache=N : cache the uniqueness of N puzzles while generating (0: no cache)
+   --seed=N : random seed of the generator
+   --time=S, --checks=N : the generator stops after S seconds or N uniqueness checks
+   --checkpoint=FILE, --checkpoint-every=S : save the generation every S seconds
+   --stats, --stats=json : print the counters of the solver and the generator
+   --timing : print latency histograms of the phases
+   --trace=FILE : also write every phase to FILE (Chrome trace format)*/
+int sudoku_option(sudoku_ctx *c,const char *opt){
+  if(!strncmp(opt,"--threads=",10))
+    c->n_threads=atoi(opt+10);
+  else if(!strcmp(opt,"--mrv"))
+    c->search_order=ORDER_MRV;
+  else if(!strcmp(opt,"--dlx"))
+    c->engine=ENGINE_DLX;
+  else if(!strcmp(opt,"--no-propagate"))
+    c->propagation=0;
+  else if(!strcmp(opt,"--lockstep"))
+    c->lockstep=1;
+  else if(!strcmp(opt,"--packed"))
+    c->format=FORMAT_PACKED;
+  else if(!strcmp(opt,"--ranked"))
+    c->format=FORMAT_RANKED;
+  else if(!strncmp(opt,"--cache=",8))
+    c->cache_size=atoi(opt+8);
+  else if(!strcmp(opt,"--stats") || !strcmp(opt,"--stats=text"))
+    c->stats_format=STATS_TEXT;
+  else if(!strcmp(opt,"--stats=json"))
+    c->stats_format=STATS_JSON;
+  else if(!strcmp(opt,"--timing")){
+    if(c->timing==TIMING_OFF)
+      c->timing=TIMING_ON;
+  }
+  else if(!strncmp(opt,"--trace=",8)){
+    c->timing=TIMING_TRACE;
+    c->trace_file=opt+8;
+  }
+  else if(!strncmp(opt,"--seed=",7))
+    c->seed=strtoull(opt+7,NULL,10);
+  else if(!strncmp(opt,"--time=",7))
+    c->time_limit=atoi(opt+7);
+  else if(!strncmp(opt,"--checks=",9))
+    c->max_checks=atol(opt+9);
+  else if(!strncmp(opt,"--checkpoint=",13))
+    c->checkpoint=opt+13;
+  else if(!strncmp(opt,"--checkpoint-every=",19))
+    c->checkpoint_interval=atoi(opt+19);
+  else
+    return 0;
+  return 1;
+}
+
+/* Copy solver and generator settings (not the puzzle nor the results)*/
+void sudoku_settings(sudoku_ctx *to,sudoku_ctx *from){
+  to->engine=from->engine;
+  to->search_order=from->search_order;
+  to->propagation=from->propagation;
+  to->lockstep=from->lockstep;
+  to->n_threads=from->n_threads;
+  to->format=from->format;
+  to->cache_size=from->cache_size;
+  to->stats_format=from->stats_format;
+  to->timing=from->timing;
+  to->trials=from->trials;
+  to->time_limit=from->time_limit;
+  to->deadline=from->deadline;
+  to->max_checks=from->max_checks;
+  to->min_empty=from->min_empty;
+  to->max_sample=from->max_sample;
+  to->limit_empty=from->limit_empty;
+  to->seed=from->seed;
+  to->stream=from->stream;
+}
+
+/* Number of threads to use: n_threads, or one per core*/
+int sudoku_threads(sudoku_ctx *c){
+  int n=c->n_threads;
+  if(n<=0)
+    n=sysconf(_SC_NPROCESSORS_ONLN);
+  return n<1 ? 1 : n;
+}
+
+/* Swap two integers*/
+static void swap_int(int *x, int *y){
+  int tmp=*x;
+  *x=*y;
+  *y=tmp;
+}
+
+/* Swap two rows of a table*/
+static void swap_row(int arr[][SIZE],int m, int n){
+  int i;
+  for(i=0; i<SIZE; ++i)
+    swap_int(&arr[m][i],&arr[n][i]);
+}
+
+/* Convert sudoku puzzle*/
+// This is 1-1 transformation: sudoku_modified[i][j]=k means
+// i in #j row of original puzzle belongs to #k column.
+// The block rule of original puzzle becomes: in #row val, BOX_H
+// consecutive grids (val,i1),...,(val,i1+BOX_H-1) (i1=i-i%BOX_H) can't
+// take values from the same group j/BOX_W.
+static void sudoku_to_problem(sudoku_ctx *c){
+  int row,col,val;
+  int i,j;
+
+  // initialize row_index and positive
+  for(row=0; row<SIZE; ++row){
+    c->row_index[row]=row;
+    c->positive[row]=0;
+  }
+
+  // initialize sodoku_modified table
+  for(row=0; row<SIZE; ++row){
+    for(col=0; col<SIZE; ++col){
+      c->sudoku_modified[row][col]=EMPTY;
+    }
+  }
+
+  // insert numbers to sudoku_modified table correspondent
+  // with numbers and their positions in original sudoku table
+  for(row=0; row<SIZE; ++row){
+    for(col=0; col<SIZE; ++col){
+      if((val=c->sudoku[row][col])!=EMPTY){
+	c->sudoku_modified[val][row]=col;
+	++c->positive[val];  // increment the number of non-empty grids in #val row
+      }
+    }
+  }
+
+  // Numbers are permutable, so start putting the number that occurs
+  // most frequently: sort rows of modified puzzle by number of non-empty grids.
+  for(i=0; i<SIZE-1; ++i){
+    for(j=i+1;j<SIZE; ++j){
+      if(c->positive[j]>c->positive[i]){
+	swap_row(c->sudoku_modified,i,j);
+	swap_int(&c->row_index[i],&c->row_index[j]);
+      }
+    }
+  }
+}
+
+/* Convert back the modified puzzle (problem) to original puzzle*/
+void sudoku_solution(sudoku_ctx *c,int table[][SIZE]){
+  int problem_tmp[SIZE][SIZE];
+  int row,col;
+
+  for(row=0; row<SIZE; ++row){
+    for(col=0; col<SIZE; ++col){
+      problem_tmp[c->row_index[row]][col]=c->problem[row][col];
+    }
+  }
+
+  for(row=0; row<SIZE; ++row){
+    for(col=0; col<SIZE; ++col){
+      table[col][problem_tmp[row][col]]=row;
+    }
+  }
+}
+
+/* Initialization*/
+// Return -1 if there is no conflict. Otherwise, return row*SIZE+col
+// of the first grid of modified table that conflicts with previous ones.
+int sudoku_init(sudoku_ctx *c){
+  return sudoku_init_deduced(c,NULL);
+}
+
+/* Initialization with the numbers of c->sudoku and the grids deduced
+   from them: deduced[row*SIZE+col] is a number or EMPTY (NULL: none)*/
+// The modified table is ordered by the numbers of c->sudoku alone, so
+// a search goes on exactly as it would from c->sudoku once propagation
+// has found the deduced grids.
+int sudoku_init_deduced(sudoku_ctx *c,const signed char *deduced){
+  int row,col,val,k=-1;
+  int value_row[SIZE];
+  long long t=c->timing ? sudoku_now() : 0;
+
+  sudoku_to_problem(c);
+  if(deduced){
+    for(row=0; row<SIZE; ++row)
+      value_row[c->row_index[row]]=row;
+    for(k=0; k<SIZE*SIZE; ++k)
+      if(c->sudoku[k/SIZE][k%SIZE]==EMPTY && (val=deduced[k])!=EMPTY)
+	c->sudoku_modified[value_row[val]][k/SIZE]=k%SIZE;
+    k=-1;
+  }
+  t=sudoku_phase(c,PHASE_CONVERT,t);
+
+  /* Initialy, any value can be put into any positions*/
+  for(row=0; row<SIZE; ++row){
+    c->column[row]=0;
+    c->rows[row]=0;
+    for(col=0; col<SIZE/BOX_H; ++col)
+      c->block[row][col]=0;
+  }
+
+  /* Initialize used state of sudoku puzzles*/
+  for(row=0; row<SIZE && k<0; ++row){
+    for(col=0; col<SIZE; ++col){
+      c->problem[row][col]=EMPTY;
+      if((val=c->sudoku_modified[row][col])>=0){
+	if(!(CANDIDATES(c,row,col)>>val&1)){
+	  k=row*SIZE+col;
+	  break;
+	}
+	update(c,row,col,val);
+      }
+    }
+  }
+  sudoku_phase(c,PHASE_INIT,t);
+  return k;
+}
+
+/* Row of the modified table holding value val*/
+static int value_row(sudoku_ctx *c,int val){
+  int row;
+  for(row=0; c->row_index[row]!=val; ++row);
+  return row;
+}
+
+/* Remove the given number of (row,col) grid from the initialized state*/
+// The puzzle differs from the one given to sudoku_init() by one grid,
+// so only this grid is updated instead of calling sudoku_init() again.
+void sudoku_unset(sudoku_ctx *c,int row,int col){
+  int val=c->sudoku[row][col],r;
+  if(val==EMPTY)
+    return;
+  r=value_row(c,val);
+  remove_update(c,r,row,col);
+  c->sudoku_modified[r][row]=EMPTY;
+  --c->positive[val];   // counted by value, as in sudoku_to_problem()
+  c->sudoku[row][col]=EMPTY;
+}
+
+/* Put number val into the empty (row,col) grid of the initialized state*/
+// Return 0 (nothing changed) if val conflicts with the other numbers.
+int sudoku_set(sudoku_ctx *c,int row,int col,int val){
+  int r=value_row(c,val);
+  if(c->sudoku[row][col]!=EMPTY || !(CANDIDATES(c,r,row)>>col&1))
+    return 0;
+  update(c,r,row,col);
+  c->sudoku_modified[r][row]=col;
+  ++c->positive[val];
+  c->sudoku[row][col]=val;
+  return 1;
+}
+
+/* Find solutions*/
+// Terminate as soon as n_ans reaches max_ans (if max_ans>0)
+int sudoku_solve(sudoku_ctx *c){
+  c->n_ans=0;
+  if(sudoku_init(c)>=0){
+    c->n_nodes=c->n_backtracks=0;
+    return 0;    // a conflict, no solution
+  }
+  return sudoku_search(c);
+}
+
+/* Number of solutions of c->sudoku, counting stops at limit (0: all)*/
+int sudoku_count(sudoku_ctx *c,int limit){
+  void (*found)(sudoku_ctx *)=c->solution_found;
+  int max_ans=c->max_ans;
+
+  c->solution_found=NULL;
+  c->max_ans=limit;
+  sudoku_solve(c);
+  c->solution_found=found;
+  c->max_ans=max_ans;
+  return c->n_ans;
+}
+
+/* Count a solution other than the known one as a second solution*/
+static void other_solution(sudoku_ctx *c){
+  int row,col;
+  for(row=0; row<SIZE; ++row)
+    for(col=0; col<SIZE; ++col)
+      if(c->problem[row][col]!=c->guide[row][col]){
+	c->n_ans=2;
+	return;
+      }
+}
+
+/* The initialized puzzle has no solution but c->known*/
+// c->known is a solution of the puzzle. Every grid tries its known value
+// last, so the first solution found is another one if there is any:
+// searching stops at the first solution.
+// Dancing Links has its own order: it stops at the second solution.
+int sudoku_unique(sudoku_ctx *c){
+  void (*found)(sudoku_ctx *)=c->solution_found;
+  int max_ans=c->max_ans;
+  int row,col,r;
+
+  for(r=0; r<SIZE; ++r)
+    for(row=0; row<SIZE; ++row)
+      for(col=0; col<SIZE; ++col)
+	if(c->known[row][col]==c->row_index[r])
+	  c->guide[r][row]=col;
+  c->n_ans=0;
+  if(c->engine==ENGINE_DLX){
+    c->solution_found=NULL;
+    c->max_ans=2;
+  }
+  else{
+    c->solution_found=other_solution;
+    c->max_ans=1;
+    c->guided=1;
+  }
+  sudoku_search(c);
+  c->guided=0;
+  c->solution_found=found;
+  c->max_ans=max_ans;
+  return c->n_ans==1;
+}
+
+/* Search from the initialized state with the selected order*/
+int sudoku_search(sudoku_ctx *c){
+  long long t=c->timing ? sudoku_now() : 0;
+
+  c->n_nodes=c->n_backtracks=0;
+  STAT(c,searches);
+  if(c->engine==ENGINE_DLX)
+    sudoku_dlx_search(c);
+  else{
+    c->trail_top=0;
+    if(!c->propagation || propagate(c))
+      search(c);
+    else
+      ++c->n_backtracks;
+    unpropagate(c,0);
+  }
+  sudoku_phase(c,PHASE_SEARCH,t);
+  STAT_ADD(c,nodes,c->n_nodes);
+  STAT_ADD(c,dead_ends,c->n_backtracks);
+  return c->n_ans;
+}
+
+/* A solution is found*/
+static void found(sudoku_ctx *c){
+  ++c->n_ans;
+  STAT(c,solutions);
+  if(c->solution_found)
+    c->solution_found(c);
+}
+
+/* Next grid to fill, from grid k on, with its candidates in *cand*/
+// Fixed order: the next empty grid. MRV: the empty grid with the fewest
+// candidates (Minimum Remaining Values). Return -1 if there is none.
+static int next_grid(sudoku_ctx *c,int k,unsigned int *cand){
+  unsigned int m;
+  int n,best=-1,min=SIZE+1;
+
+  if(c->search_order!=ORDER_MRV){
+    for(; k<SIZE*SIZE; ++k)
+      if(c->problem[k/SIZE][k%SIZE]==EMPTY){
+	*cand=CANDIDATES(c,k/SIZE,k%SIZE);
+	return k;
+      }
+    return -1;
+  }
+  for(k=0; k<SIZE*SIZE; ++k){
+    if(c->problem[k/SIZE][k%SIZE]!=EMPTY)
+      continue;
+    m=CANDIDATES(c,k/SIZE,k%SIZE);
+    if((n=__builtin_popcount(m))<min){
+      min=n;
+      best=k;
+      *cand=m;
+      if(n<=1)   // can't do better
+	break;
+    }
+  }
+  return best;
+}
+
+/* Put numbers into sudoku table
+   Backtracking Algorithm on the explicit stack c->stack*/
+// Every frame is an empty grid being filled: the values not tried yet
+// there and the trail position before the value tried now. The next
+// grid is pushed after every value put, a grid without any value left
+// is popped. Given and forced grids never get a frame.
+static void search(sudoku_ctx *c){
+  struct sudoku_frame *f;
+  unsigned int cand;
+  int k=0,row,col;
+
+  c->depth=0;
+  for(;;){
+    /* No empty grid ---> a solution is found*/
+    if((k=next_grid(c,k,&cand))<0)
+      found(c);
+    else{
+      if(!cand)
+	++c->n_backtracks;   // dead end
+      f=&c->stack[c->depth++];
+      f->grid=k;
+      f->mark=-1;
+      f->cand=ROTATE(cand,LAST_VALUE(c,k/SIZE,k%SIZE));
+    }
+
+    /* Try the next "val" of the top grid, pop the grids without one*/
+    for(;;){
+      if(!c->depth)
+	return;
+      f=&c->stack[c->depth-1];
+      row=f->grid/SIZE;
+      col=f->grid%SIZE;
+      if(f->mark>=0){
+	unpropagate(c,f->mark);                         // remove forced numbers
+	remove_update(c,row,col,c->problem[row][col]);  // remove "val" from (row,col) grid
+	STAT_LEAVE(c);
+	f->cand&=f->cand-1;
+	if(c->max_ans && c->n_ans>=c->max_ans)
+	  f->cand=0;   // enough solutions: unwind
+      }
+      if(!f->cand){
+	--c->depth;
+	continue;
+      }
+      update(c,row,col,VALUE(f->cand,LAST_VALUE(c,row,col)));
+      ++c->n_nodes;
+      STAT_ENTER(c);
+      f->mark=c->trail_top;
+      if(!c->propagation || propagate(c))
+	break;
+      ++c->n_backtracks;   // dead end
+    }
+    k=f->grid+1;
+  }
+}
+
+/* Put a forced number and remember it so that unpropagate() can remove it*/
+static void force(sudoku_ctx *c,int row,int col,int val){
+  update(c,row,col,val);
+  STAT(c,forced);
+  c->trail[c->trail_top++]=row*SIZE+col;
+}
+
+/* Constraint propagation*/
+// Put forced numbers until nothing changes (fixpoint):
+// * naked single: an empty grid with only one candidate
+//   (in original puzzle: a number has only one place in a row)
+// * hidden single in a row of modified table: a value has only one place
+//   (in original puzzle: a number has only one place in a column)
+// * hidden single in a column of modified table: a value has only one place
+//   (in original puzzle: a grid has only one candidate)
+// * hidden single in a block: a group of values has only one place and
+//   that grid has only one candidate in the group
+//   (in original puzzle: a number has only one place in a block)
+// Return 0 as soon as a contradiction is found.
+static int propagate(sudoku_ctx *c){
+  unsigned int cand,once,twice,need,single,group;
+  int row,col,val,k,i,s,changed;
+
+  do{
+    changed=0;
+    /* Naked singles*/
+    for(k=0; k<SIZE*SIZE; ++k){
+      row=k/SIZE;
+      col=k%SIZE;
+      if(c->problem[row][col]!=EMPTY)
+	continue;
+      if(!(cand=CANDIDATES(c,row,col)))
+	return 0;
+      if(!(cand&(cand-1))){
+	force(c,row,col,__builtin_ctz(cand));
+	changed=1;
+      }
+    }
+    /* Hidden singles in rows*/
+    for(row=0; row<SIZE; ++row){
+      once=twice=0;
+      for(col=0; col<SIZE; ++col){
+	if(c->problem[row][col]==EMPTY){
+	  cand=CANDIDATES(c,row,col);
+	  twice|=once&cand;
+	  once|=cand;
+	}
+      }
+      need=~c->rows[row]&ALL_VALUES;
+      if(need&~once)
+	return 0;
+      for(single=once&~twice&need; single; single&=single-1){
+	val=__builtin_ctz(single);
+	for(col=0; col<SIZE; ++col)
+	  if(c->problem[row][col]==EMPTY && CANDIDATES(c,row,col)>>val&1)
+	    break;
+	if(col==SIZE)
+	  return 0;
+	force(c,row,col,val);
+	changed=1;
+      }
+    }
+    /* Hidden singles in columns*/
+    for(col=0; col<SIZE; ++col){
+      once=twice=0;
+      for(row=0; row<SIZE; ++row){
+	if(c->problem[row][col]==EMPTY){
+	  cand=CANDIDATES(c,row,col);
+	  twice|=once&cand;
+	  once|=cand;
+	}
+      }
+      need=~c->column[col]&ALL_VALUES;
+      if(need&~once)
+	return 0;
+      for(single=once&~twice&need; single; single&=single-1){
+	val=__builtin_ctz(single);
+	for(row=0; row<SIZE; ++row)
+	  if(c->problem[row][col]==EMPTY && CANDIDATES(c,row,col)>>val&1)
+	    break;
+	if(row==SIZE)
+	  return 0;
+	force(c,row,col,val);
+	changed=1;
+      }
+    }
+    /* Hidden singles in blocks*/
+    for(row=0; row<SIZE; ++row){
+      for(i=0; i<SIZE/BOX_H; ++i){
+	once=twice=0;
+	for(col=i*BOX_H; col<i*BOX_H+BOX_H; ++col){
+	  if(c->problem[row][col]==EMPTY){
+	    cand=CANDIDATES(c,row,col);
+	    for(group=0,s=0; s<SIZE; s+=BOX_W)
+	      if(cand>>s&GROUP_MASK)
+		group|=GROUP_MASK<<s;
+	    twice|=once&group;
+	    once|=group;
+	  }
+	}
+	need=~c->block[row][i]&ALL_VALUES;
+	if(need&~once)
+	  return 0;
+	for(single=once&~twice&need; single; single&=~(GROUP_MASK<<s)){
+	  s=__builtin_ctz(single);   // one group at a time
+	  for(col=i*BOX_H; col<i*BOX_H+BOX_H; ++col)
+	    if(c->problem[row][col]==EMPTY && CANDIDATES(c,row,col)>>s&GROUP_MASK)
+	      break;
+	  if(col==i*BOX_H+BOX_H)
+	    return 0;
+	  cand=CANDIDATES(c,row,col)&GROUP_MASK<<s;
+	  if(!(cand&(cand-1))){
+	    force(c,row,col,__builtin_ctz(cand));
+	    changed=1;
+	  }
+	}
+      }
+    }
+  }while(changed);
+  return 1;
+}
+
+/* Remove numbers put by propagate() after the trail position mark*/
+static void unpropagate(sudoku_ctx *c,int mark){
+  int k;
+  while(c->trail_top>mark){
+    k=c->trail[--c->trail_top];
+    remove_update(c,k/SIZE,k%SIZE,c->problem[k/SIZE][k%SIZE]);
+  }
+}
+
+/* Put a new number into sudoku table and update correspondent used state*/
+static void update(sudoku_ctx *c,int row,int col, int val){
+  STAT(c,updates);
+  c->problem[row][col]=val;           // value update
+  c->column[col]|=1u<<val;            // column status update
+  c->rows[row]|=1u<<val;              // rows status update
+  c->block[row][col/BOX_H]|=GROUP(val);  // block status update
+}
+
+/* Remove a number from sudoku table and update correspondent used state*/
+static void remove_update(sudoku_ctx *c,int row,int col, int val){
+  STAT(c,remove_updates);
+  c->problem[row][col]=EMPTY;
+  c->column[col]&=~(1u<<val);
+  c->rows[row]&=~(1u<<val);
+  c->block[row][col/BOX_H]&=~GROUP(val);
+}
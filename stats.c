@@ -0,0 +1,66 @@
+/*Project: Sudoku Creator
+  Description: Counters of the solver and the generator (--stats).
+  They are counted only when libsudoku is built with SUDOKU_STATS
+  (make STATS=0 compiles them out).*/
+
+#include<stdio.h>
+#include<stddef.h>
+#include"sudoku.h"
+
+/* Counters printed, in order*/
+static const struct{
+  const char *name;
+  size_t offset;
+}counters[]={
+  {"searches",offsetof(struct sudoku_stats,searches)},
+  {"nodes",offsetof(struct sudoku_stats,nodes)},
+  {"dead_ends",offsetof(struct sudoku_stats,dead_ends)},
+  {"max_depth",offsetof(struct sudoku_stats,max_depth)},
+  {"updates",offsetof(struct sudoku_stats,updates)},
+  {"remove_updates",offsetof(struct sudoku_stats,remove_updates)},
+  {"forced",offsetof(struct sudoku_stats,forced)},
+  {"solutions",offsetof(struct sudoku_stats,solutions)},
+  {"samples",offsetof(struct sudoku_stats,samples)},
+  {"samples_unique",offsetof(struct sudoku_stats,samples_unique)},
+  {"removals",offsetof(struct sudoku_stats,removals)},
+  {"removals_unique",offsetof(struct sudoku_stats,removals_unique)},
+  {"set_rejects",offsetof(struct sudoku_stats,set_rejects)},
+  {"lockstep",offsetof(struct sudoku_stats,lockstep)},
+};
+#define N_COUNTERS (int)(sizeof(counters)/sizeof(counters[0]))
+#define COUNTER(s,i) (*(long *)((char *)(s)+counters[i].offset))
+
+/* Add the counters of "from" to "to" (max_depth: the biggest one)*/
+void sudoku_stats_add(struct sudoku_stats *to,struct sudoku_stats *from){
+  int i;
+  for(i=0; i<N_COUNTERS; ++i){
+    if(counters[i].offset==offsetof(struct sudoku_stats,max_depth)){
+      if(from->max_depth>to->max_depth)
+	to->max_depth=from->max_depth;
+    }
+    else
+      COUNTER(to,i)+=COUNTER(from,i);
+  }
+}
+
+/* Print the counters of c (and its cache) as text or JSON*/
+void sudoku_print_stats(sudoku_ctx *c,FILE *fp){
+  int i;
+  if(c->stats_format==STATS_JSON){
+    fprintf(fp,"{");
+    for(i=0; i<N_COUNTERS; ++i)
+      fprintf(fp,"\"%s\":%ld,",counters[i].name,COUNTER(&c->stats,i));
+    fprintf(fp,"\"cache_hits\":%ld,\"cache_misses\":%ld}\n",
+	    c->cache_hits,c->cache_misses);
+    return;
+  }
+#ifdef SUDOKU_STATS
+  fprintf(fp,"Statistics:\n");
+#else
+  fprintf(fp,"Statistics (built without SUDOKU_STATS, only the cache is counted):\n");
+#endif
+  for(i=0; i<N_COUNTERS; ++i)
+    fprintf(fp,"  %-16s %ld\n",counters[i].name,COUNTER(&c->stats,i));
+  fprintf(fp,"  %-16s %ld\n  %-16s %ld\n","cache_hits",c->cache_hits,
+	  "cache_misses",c->cache_misses);
+}
@@ -0,0 +1,388 @@
+/*Project: Sudoku Creator
+  Description: libsudoku, the solver and generator shared by fast, final
+  and invent. Every function takes an explicit context, so one context
+  per thread can be used without locks.*/
+#ifndef SUDOKU_H
+#define SUDOKU_H
+
+#include<stdio.h>
+#include<stdatomic.h>
+
+/* Block dimensions, fixed at compile time: make BOX_W=4 for 16x16,
+   make BOX_W=5 for 25x25, make BOX_W=3 BOX_H=2 for 6x6,...*/
+#ifndef BOX_W
+#define BOX_W 3        // columns of a block
+#endif
+#ifndef BOX_H
+#define BOX_H BOX_W    // rows of a block
+#endif
+#define SIZE (BOX_W*BOX_H)   // Sudoku table size
+#if SIZE>25
+#error "SIZE must fit the 32-bit masks (25 at most)"
+#endif
+
+/* Every size is a library of its own (libsudoku3x3, libsudoku4x4,...)
+   whose symbols carry the block dimensions: sudoku_solve is
+   sudoku3x3_solve,... Several sizes can be linked into one program, and
+   code compiled with other dimensions than the library doesn't link.*/
+#define SUDOKU_NAME(w,h,name) sudoku##w##x##h##_##name
+#define SUDOKU_SYM(w,h,name) SUDOKU_NAME(w,h,name)
+#define sudoku_batch SUDOKU_SYM(BOX_W,BOX_H,batch)
+#define sudoku_cache_clear SUDOKU_SYM(BOX_W,BOX_H,cache_clear)
+#define sudoku_cache_free SUDOKU_SYM(BOX_W,BOX_H,cache_free)
+#define sudoku_cache_get SUDOKU_SYM(BOX_W,BOX_H,cache_get)
+#define sudoku_cache_put SUDOKU_SYM(BOX_W,BOX_H,cache_put)
+#define sudoku_cancel SUDOKU_SYM(BOX_W,BOX_H,cancel)
+#define sudoku_check_solution SUDOKU_SYM(BOX_W,BOX_H,check_solution)
+#define sudoku_copy SUDOKU_SYM(BOX_W,BOX_H,copy)
+#define sudoku_count SUDOKU_SYM(BOX_W,BOX_H,count)
+#define sudoku_covers SUDOKU_SYM(BOX_W,BOX_H,covers)
+#define sudoku_delete SUDOKU_SYM(BOX_W,BOX_H,delete)
+#define sudoku_dlx_free SUDOKU_SYM(BOX_W,BOX_H,dlx_free)
+#define sudoku_dlx_search SUDOKU_SYM(BOX_W,BOX_H,dlx_search)
+#define sudoku_empty SUDOKU_SYM(BOX_W,BOX_H,empty)
+#define sudoku_generate SUDOKU_SYM(BOX_W,BOX_H,generate)
+#define sudoku_generate_parallel SUDOKU_SYM(BOX_W,BOX_H,generate_parallel)
+#define sudoku_init SUDOKU_SYM(BOX_W,BOX_H,init)
+#define sudoku_init_deduced SUDOKU_SYM(BOX_W,BOX_H,init_deduced)
+#define sudoku_load SUDOKU_SYM(BOX_W,BOX_H,load)
+#define sudoku_map SUDOKU_SYM(BOX_W,BOX_H,map)
+#define sudoku_mask_of SUDOKU_SYM(BOX_W,BOX_H,mask_of)
+#define sudoku_new_abi SUDOKU_SYM(BOX_W,BOX_H,new_abi)
+#define sudoku_now SUDOKU_SYM(BOX_W,BOX_H,now)
+#define sudoku_option SUDOKU_SYM(BOX_W,BOX_H,option)
+#define sudoku_pack SUDOKU_SYM(BOX_W,BOX_H,pack)
+#define sudoku_parse SUDOKU_SYM(BOX_W,BOX_H,parse)
+#define sudoku_phase SUDOKU_SYM(BOX_W,BOX_H,phase)
+#define sudoku_print SUDOKU_SYM(BOX_W,BOX_H,print)
+#define sudoku_print_stats SUDOKU_SYM(BOX_W,BOX_H,print_stats)
+#define sudoku_print_timing SUDOKU_SYM(BOX_W,BOX_H,print_timing)
+#define sudoku_rank SUDOKU_SYM(BOX_W,BOX_H,rank)
+#define sudoku_read SUDOKU_SYM(BOX_W,BOX_H,read)
+#define sudoku_resume SUDOKU_SYM(BOX_W,BOX_H,resume)
+#define sudoku_save SUDOKU_SYM(BOX_W,BOX_H,save)
+#define sudoku_scan SUDOKU_SYM(BOX_W,BOX_H,scan)
+#define sudoku_search SUDOKU_SYM(BOX_W,BOX_H,search)
+#define sudoku_set SUDOKU_SYM(BOX_W,BOX_H,set)
+#define sudoku_settings SUDOKU_SYM(BOX_W,BOX_H,settings)
+#define sudoku_size SUDOKU_SYM(BOX_W,BOX_H,size)
+#define sudoku_solution SUDOKU_SYM(BOX_W,BOX_H,solution)
+#define sudoku_solve SUDOKU_SYM(BOX_W,BOX_H,solve)
+#define sudoku_solve_from SUDOKU_SYM(BOX_W,BOX_H,solve_from)
+#define sudoku_solve_job SUDOKU_SYM(BOX_W,BOX_H,solve_job)
+#define sudoku_solve_lanes SUDOKU_SYM(BOX_W,BOX_H,solve_lanes)
+#define sudoku_stats_add SUDOKU_SYM(BOX_W,BOX_H,stats_add)
+#define sudoku_stop_on_signals SUDOKU_SYM(BOX_W,BOX_H,stop_on_signals)
+#define sudoku_threads SUDOKU_SYM(BOX_W,BOX_H,threads)
+#define sudoku_timing_add SUDOKU_SYM(BOX_W,BOX_H,timing_add)
+#define sudoku_timing_free SUDOKU_SYM(BOX_W,BOX_H,timing_free)
+#define sudoku_unavoidable SUDOKU_SYM(BOX_W,BOX_H,unavoidable)
+#define sudoku_unavoidable_free SUDOKU_SYM(BOX_W,BOX_H,unavoidable_free)
+#define sudoku_unique SUDOKU_SYM(BOX_W,BOX_H,unique)
+#define sudoku_unpack SUDOKU_SYM(BOX_W,BOX_H,unpack)
+#define sudoku_unrank SUDOKU_SYM(BOX_W,BOX_H,unrank)
+#define sudoku_unset SUDOKU_SYM(BOX_W,BOX_H,unset)
+#define sudoku_write SUDOKU_SYM(BOX_W,BOX_H,write)
+#define sudoku_write_checkpoint SUDOKU_SYM(BOX_W,BOX_H,write_checkpoint)
+#define sudoku_write_trace SUDOKU_SYM(BOX_W,BOX_H,write_trace)
+
+#define EMPTY -1       // Empty grid
+#define ALL_VALUES ((1<<SIZE)-1)   // mask with every value available
+#define GROUP_MASK ((1u<<BOX_W)-1)
+#define GROUP(val) (GROUP_MASK<<(val)/BOX_W*BOX_W)   // values of the group of val
+#define SYMBOLS "123456789ABCDEFGHIJKLMNOP"   // symbols of values 0..SIZE-1
+#define SCALE(n) ((n)*SIZE*SIZE/81)   // n grids of a 9x9 table, scaled to SIZE
+
+/* Masks of values: as narrow as SIZE allows*/
+#if SIZE<=16
+typedef unsigned short sudoku_bits;
+#else
+typedef unsigned int sudoku_bits;
+#endif
+#define SUDOKU_LANES (32/(int)sizeof(sudoku_bits))   // puzzles solved in lockstep (256-bit vectors)
+
+/* Search orders*/
+#define ORDER_FIXED 0  // grids in order k=0,1,...,SIZE*SIZE-1
+#define ORDER_MRV 1    // the grid with the fewest candidates first
+
+/* Search engines*/
+#define ENGINE_BACKTRACK 0  // search() on an explicit stack
+#define ENGINE_DLX 1        // Dancing Links
+
+/* Formats of tables in files*/
+#define FORMAT_TEXT 0     // SIZE lines of SYMBOLS and a blank line
+#define FORMAT_PACKED 1   // CELL_BITS bits per grid (SUDOKU_PACKED bytes)
+#define FORMAT_RANKED 2   // complete solutions only: rank of every row (SUDOKU_RANKED bytes)
+#define CELL_BITS (SIZE<16 ? 4 : 5)   // EMPTY and SIZE values
+#define SUDOKU_PACKED ((SIZE*SIZE*CELL_BITS+7)/8)
+/* SIZE! < 1<<RANK_BITS (0: SIZE! doesn't fit 64 bits, no ranked format)*/
+#if SIZE==4
+#define RANK_BITS 5
+#elif SIZE==6
+#define RANK_BITS 10
+#elif SIZE==8
+#define RANK_BITS 16
+#elif SIZE==9
+#define RANK_BITS 19
+#elif SIZE==10
+#define RANK_BITS 22
+#elif SIZE==12
+#define RANK_BITS 29
+#elif SIZE==15
+#define RANK_BITS 41
+#elif SIZE==16
+#define RANK_BITS 45
+#elif SIZE==20
+#define RANK_BITS 62
+#else
+#define RANK_BITS 0
+#endif
+#define SUDOKU_RANKED (((SIZE-1)*RANK_BITS+7)/8)   // the last row is given by the columns
+
+/* Status of a job of a batch*/
+#define JOB_SOLVED 0    // one and only one solution
+#define JOB_MULTIPLE 1  // more than one solution
+#define JOB_NONE 2      // no solution
+#define JOB_INVALID 3   // the given numbers conflict
+
+/* Set of grids: bit row*SIZE+col*/
+#define MASK_WORDS ((SIZE*SIZE+63)/64)
+typedef unsigned long long sudoku_mask[MASK_WORDS];
+
+/* Formats of the statistics (--stats)*/
+#define STATS_NONE 0
+#define STATS_TEXT 1
+#define STATS_JSON 2
+
+/* Counters of the solver and the generator*/
+// Counted only when libsudoku is built with SUDOKU_STATS.
+struct sudoku_stats{
+  long searches;         // sudoku_search() calls
+  long nodes;            // values put by the searches
+  long dead_ends;        // no candidate or contradiction
+  long max_depth;        // most values on the search stack at once
+  long depth;            // values on the search stack now
+  long updates;          // update() calls
+  long remove_updates;   // remove_update() calls
+  long forced;           // numbers put by propagation
+  long solutions;
+  long samples;          // random puzzles tested by the generator
+  long samples_unique;
+  long removals;         // pairs removed by generate()
+  long removals_unique;
+  long set_rejects;      // puzzles rejected by unavoidable sets
+  long lockstep;         // puzzles solved by lockstep propagation alone
+};
+
+#ifdef SUDOKU_STATS
+#define STAT(c,field) (++(c)->stats.field)
+#define STAT_ADD(c,field,n) ((c)->stats.field+=(n))
+#define STAT_ENTER(c) \
+  ((c)->stats.max_depth<++(c)->stats.depth ? (c)->stats.max_depth=(c)->stats.depth : 0)
+#define STAT_LEAVE(c) (--(c)->stats.depth)
+#else
+#define STAT(c,field) ((void)0)
+#define STAT_ADD(c,field,n) ((void)0)
+#define STAT_ENTER(c) ((void)0)
+#define STAT_LEAVE(c) ((void)0)
+#endif
+
+/* Timed phases (--timing, --trace)*/
+#define PHASE_PARSE 0     // reading puzzles
+#define PHASE_CONVERT 1   // sudoku_to_problem()
+#define PHASE_INIT 2      // used state of sudoku_init()
+#define PHASE_SEARCH 3    // sudoku_search()
+#define PHASE_OUTPUT 4    // writing tables
+#define N_PHASES 5
+#define HIST_BUCKETS 48   // bucket b: [2^b,2^(b+1)) nanoseconds
+#define TIMING_OFF 0
+#define TIMING_ON 1       // histograms
+#define TIMING_TRACE 2    // histograms and a trace of every phase
+
+typedef struct sudoku_ctx sudoku_ctx;
+typedef struct sudoku_job sudoku_job;
+struct sudoku_best;
+struct sudoku_sets;
+struct sudoku_cache;
+struct sudoku_timing;
+
+/* A generating thread at the start of a trial (checkpoints)*/
+struct sudoku_state{
+  unsigned long long rng[4];   // random numbers before the trial
+  int done;                    // trials done
+};
+
+/* A grid being filled by the search (c->stack)*/
+struct sudoku_frame{
+  unsigned short grid;   // row*SIZE+col of the modified table
+  short mark;            // trail position before the value tried (-1: none yet)
+  sudoku_bits cand;      // values left, rotated: the lowest one is tried now
+};
+
+/* A puzzle of a batch: grid[row*SIZE+col] is a number 0..SIZE-1 or EMPTY*/
+struct sudoku_job{
+  signed char grid[SIZE*SIZE];
+  signed char solution[SIZE*SIZE];   // the first solution found
+  int status;                        // JOB_SOLVED,...
+};
+
+struct sudoku_ctx{
+  /* Problem*/
+  int sudoku[SIZE][SIZE];            // Original sudoku puzzle
+  /* Variables used to find solutions*/
+  int sudoku_modified[SIZE][SIZE];   // modified sudoku puzzle
+  int problem[SIZE][SIZE];           // a copy of modified sudoku puzzle used to find solutions
+  int row_index[SIZE];               // index of a row of modified puzzle
+  int positive[SIZE];                // positive[val]: number of grids holding val
+
+  /* Used state representing (modified table)*/
+  // Bit "val" of a mask is set when "val" is already used.
+  // column[col]: values used in column "col"
+  // rows[row]: values used in row "row"
+  // block[row][col/BOX_H]: the BOX_W values of GROUP(val) are all set
+  // when a value of that group is used in the block[row][col/BOX_H]
+  sudoku_bits column[SIZE];
+  sudoku_bits rows[SIZE];
+  sudoku_bits block[SIZE][SIZE/BOX_H];
+
+  /* Grids filled by propagation, in order (row*SIZE+col)*/
+  int trail[SIZE*SIZE];
+  int trail_top;
+  struct sudoku_frame stack[SIZE*SIZE];   // search stack: one frame per grid being filled
+  int depth;                              // frames on the stack
+  struct dlx *dlx;   // Dancing Links workspace (allocated on demand)
+
+  /* Solver settings and results*/
+  int n_ans;         // number of answers
+  int max_ans;       // stop as soon as n_ans>=max_ans (0: find all solutions)
+  void (*solution_found)(sudoku_ctx *c);   // called on every solution (may be NULL)
+  void *user;        // free for the caller of the library
+  int engine;        // ENGINE_BACKTRACK or ENGINE_DLX
+  int search_order;  // ORDER_FIXED or ORDER_MRV
+  int propagation;   // apply naked/hidden singles before and during search
+  int lockstep;      // sudoku_batch() propagates SUDOKU_LANES puzzles at once first
+  long n_nodes;      // number of values put during the last search
+  long n_backtracks; // dead ends (no candidate, contradiction) of the last search
+  struct sudoku_stats stats;   // counters since the context was made
+  int stats_format;  // STATS_NONE, STATS_TEXT or STATS_JSON
+  int timing;        // TIMING_OFF, TIMING_ON or TIMING_TRACE
+  const char *trace_file;         // where the programs write the trace
+  struct sudoku_timing *times;    // histograms and trace (allocated on demand)
+  int n_threads;     // threads of sudoku_batch()/sudoku_generate_parallel() (0: one per core)
+  int format;        // FORMAT_TEXT,... of the tables written and read by the programs
+  int known[SIZE][SIZE];   // a solution known by the caller (sudoku_unique())
+  int guide[SIZE][SIZE];   // known solution in the modified table
+  int guided;              // every grid tries its known value last
+  struct sudoku_sets *sets;   // unavoidable sets of known (allocated on demand)
+  struct sudoku_cache *cache; // uniqueness of puzzles of known (allocated on demand)
+  int cache_size;          // entries of the cache (0: no cache)
+  long cache_hits,cache_misses;
+
+  /* Generator settings and results*/
+  int trials;        // number of random samples
+  int time_limit;    // maximum processing time in seconds (0: no limit)
+  long long deadline;   // stop at this sudoku_now() time (0: no deadline)
+  long max_checks;   // stop after max_checks uniqueness checks (0: no limit)
+  int min_empty;     // samples need at least min_empty empty grids
+  int max_sample;    // and less than max_sample empty grids
+  int limit_empty;   // stop when a puzzle with limit_empty empty grids is found (0: never)
+  unsigned long long seed;   // random seed
+  int stream;               // random stream of the seed (one per thread)
+  unsigned long long rng[4];   // state of the random numbers
+  int trials_done;   // sudoku_generate() starts after them with c->rng as it is
+  int trial;         // trial running
+  int max_empty;     // biggest number of empty grids found (0: none, result is the solution)
+  int result[SIZE][SIZE];   // the final puzzle created (best one)
+  // called on every better puzzle (max_empty and result are updated);
+  // calls are one at a time, from the generating threads
+  void (*improved)(sudoku_ctx *c);
+  long n_checks;            // uniqueness checks of the last generation
+  long long stop_time;      // deadline of the generation running
+  atomic_int cancelled;     // set by sudoku_cancel()
+  const char *checkpoint;   // file of the checkpoints (NULL: none)
+  int checkpoint_interval;  // seconds between checkpoints
+  struct sudoku_state *states;   // every thread of the generation (checkpoints)
+  int n_states;
+  struct sudoku_best *best; // best result shared by parallel generators (or NULL)
+};
+
+/* Candidates of (row,col) grid in the modified table*/
+#define CANDIDATES(c,row,col) \
+  (~((c)->column[col]|(c)->rows[row]|(c)->block[row][(col)/BOX_H])&ALL_VALUES)
+
+/* Context*/
+// sudoku_new(): allocate a context with default settings, NULL if the
+// sudoku_ctx of the caller isn't the one of the library
+#define sudoku_new() sudoku_new_abi(sizeof(sudoku_ctx))
+sudoku_ctx *sudoku_new_abi(size_t size);
+int sudoku_size(void);                // SIZE of the library
+void sudoku_delete(sudoku_ctx *c);
+int sudoku_option(sudoku_ctx *c,const char *opt);   // apply a solver option, return 0 if unknown
+void sudoku_settings(sudoku_ctx *to,sudoku_ctx *from);   // copy solver and generator settings
+int sudoku_threads(sudoku_ctx *c);    // number of threads to use
+
+/* Finding solutions functions*/
+int sudoku_init(sudoku_ctx *c);       // initialization, return -1 or the first conflicting grid
+int sudoku_init_deduced(sudoku_ctx *c,const signed char *deduced);   // the same, with grids deduced from c->sudoku
+int sudoku_search(sudoku_ctx *c);     // search from the initialized state, return n_ans
+int sudoku_unique(sudoku_ctx *c);     // c->known is the only solution of the initialized puzzle
+int sudoku_unavoidable(sudoku_ctx *c);   // find unavoidable sets of c->known, return their number
+void sudoku_mask_of(int table[][SIZE],sudoku_mask m);   // grids of a table that are not empty
+int sudoku_covers(sudoku_ctx *c,const sudoku_mask given);   // given keeps a grid of every unavoidable set
+void sudoku_unavoidable_free(sudoku_ctx *c);
+int sudoku_cache_get(sudoku_ctx *c,const sudoku_mask given);   // 1: unique, 0: not unique, -1: unknown
+void sudoku_cache_put(sudoku_ctx *c,const sudoku_mask given,int unique);
+void sudoku_cache_clear(sudoku_ctx *c);   // forget every puzzle (known has changed)
+void sudoku_cache_free(sudoku_ctx *c);
+void sudoku_unset(sudoku_ctx *c,int row,int col);        // remove a given number from the initialized state
+int sudoku_set(sudoku_ctx *c,int row,int col,int val);   // put it back, return 0 on conflict
+int sudoku_solve(sudoku_ctx *c);      // initialize and search, return n_ans
+int sudoku_count(sudoku_ctx *c,int limit);   // number of solutions, counting stops at limit (0: all)
+void sudoku_solution(sudoku_ctx *c,int table[][SIZE]);   // reverse the modified puzzle into table
+int sudoku_dlx_search(sudoku_ctx *c); // search with Dancing Links, return n_ans
+void sudoku_dlx_free(sudoku_ctx *c);
+
+/* Solving many puzzles*/
+void sudoku_solve_job(sudoku_ctx *c,sudoku_job *job);
+void sudoku_solve_from(sudoku_ctx *c,sudoku_job *job,const signed char *deduced);   // the same, from deduced grids
+int sudoku_batch(sudoku_ctx *c,sudoku_job *jobs,int n,int n_threads);   // solve jobs on n_threads cores
+void sudoku_solve_lanes(sudoku_ctx *c,sudoku_job *jobs,int n);   // solve jobs in lockstep, then one at a time
+
+/* Create new puzzle functions*/
+int sudoku_generate(sudoku_ctx *c);   // create a puzzle from the solution in c->sudoku, return max_empty
+int sudoku_generate_parallel(sudoku_ctx *c);   // the same, trials are shared by c->n_threads threads
+void sudoku_cancel(sudoku_ctx *c);    // stop the generation of c (any thread, signal handlers)
+void sudoku_stop_on_signals(sudoku_ctx *c);   // Ctrl+C and SIGTERM call sudoku_cancel(c)
+int sudoku_check_solution(sudoku_ctx *c);     // c->sudoku is a complete solution, else print why
+int sudoku_write_checkpoint(sudoku_ctx *c,long checks);   // save the generation to c->checkpoint
+int sudoku_resume(sudoku_ctx *c,const char *path);        // go on from a checkpoint, return 0 on failure
+
+/* Statistics*/
+void sudoku_stats_add(struct sudoku_stats *to,struct sudoku_stats *from);
+void sudoku_print_stats(sudoku_ctx *c,FILE *fp);   // print the counters in c->stats_format
+
+/* Timing*/
+long long sudoku_now(void);           // monotonic wall clock (ns)
+long long sudoku_phase(sudoku_ctx *c,int phase,long long start);   // record a phase, return the time now
+void sudoku_timing_add(sudoku_ctx *to,sudoku_ctx *from,int tid);   // merge the timing of thread tid
+void sudoku_print_timing(sudoku_ctx *c,FILE *fp);
+int sudoku_write_trace(sudoku_ctx *c,const char *path);
+void sudoku_timing_free(sudoku_ctx *c);
+
+/* In-Out functions*/
+int sudoku_read(FILE *fp,int table[][SIZE]);         // get sudoku from a file, return 0 on failure
+int sudoku_scan(const char *s,int table[][SIZE]);    // get a puzzle from a word of SIZE*SIZE symbols
+int sudoku_parse(const char *buf,size_t len,sudoku_job **jobs,int *n,int *max);   // add the puzzles of a buffer to jobs
+int sudoku_map(const char *path,sudoku_job **jobs,int *n,int *max);   // the same for a memory-mapped file
+void sudoku_print(int table[][SIZE],FILE *fp);       // print a table
+void sudoku_save(int table[][SIZE],FILE *fp);        // save a table as digits
+void sudoku_copy(int to[][SIZE],int from[][SIZE]);   // copy two tables
+void sudoku_pack(int table[][SIZE],unsigned char *buf);          // CELL_BITS bits per grid
+void sudoku_unpack(const unsigned char *buf,int table[][SIZE]);
+int sudoku_rank(int table[][SIZE],unsigned char *buf);           // rank a solution, return 0 if not complete
+int sudoku_unrank(const unsigned char *buf,int table[][SIZE]);   // return 0 if buf is not a ranked table
+int sudoku_write(int table[][SIZE],FILE *fp,int format);         // save a table, return 0 on failure
+int sudoku_load(FILE *fp,int table[][SIZE],int format);          // get a table, return 0 on failure
+int sudoku_empty(int table[][SIZE]);                 // number of empty grids in a table
+
+#endif
@@ -0,0 +1,169 @@
+/*Project: Sudoku Creator
+  Description: Latency of the phases of libsudoku (--timing, --trace).
+  Every phase (parse, conversion, init, search, output) is timed with
+  the monotonic clock. Durations go into a histogram per phase (bucket b
+  holds [2^b,2^(b+1)) nanoseconds) and, with --trace, into a list of
+  events written in the Chrome trace event format (chrome://tracing,
+  Perfetto).*/
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include"sudoku.h"
+
+#define MAX_EVENTS (1<<20)   // events kept by a trace, later ones are dropped
+
+/* One timed phase of a trace*/
+struct event{
+  long long start;   // ns
+  long long dur;
+  int phase;
+  int tid;           // thread (worker) that timed it
+};
+
+struct sudoku_timing{
+  long count[N_PHASES];
+  long long total[N_PHASES];             // ns
+  long hist[N_PHASES][HIST_BUCKETS];
+  struct event *events;
+  int n_events,max_events;
+  long dropped;                          // events over MAX_EVENTS
+};
+
+static const char *phase_name[N_PHASES]={"parse","convert","init","search","output"};
+
+/* Monotonic wall clock in nanoseconds*/
+long long sudoku_now(void){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec*1000000000LL+t.tv_nsec;
+}
+
+static struct sudoku_timing *timing(sudoku_ctx *c){
+  if(!c->times)
+    c->times=calloc(1,sizeof(struct sudoku_timing));
+  return c->times;
+}
+
+/* Keep an event, return 0 if there is no room*/
+static int add_event(struct sudoku_timing *t,long long start,long long dur,int phase,int tid){
+  struct event *e;
+  if(t->n_events==t->max_events){
+    if(t->max_events>=MAX_EVENTS ||
+       !(e=realloc(t->events,(t->max_events ? 2*t->max_events : 1024)*sizeof(struct event)))){
+      ++t->dropped;
+      return 0;
+    }
+    t->events=e;
+    t->max_events=t->max_events ? 2*t->max_events : 1024;
+  }
+  e=&t->events[t->n_events++];
+  e->start=start;
+  e->dur=dur;
+  e->phase=phase;
+  e->tid=tid;
+  return 1;
+}
+
+/* The phase started at "start" is over: record it, return the time now*/
+// Nothing is recorded when c->timing is TIMING_OFF.
+long long sudoku_phase(sudoku_ctx *c,int phase,long long start){
+  struct sudoku_timing *t;
+  long long end,dur;
+  int b;
+
+  if(c->timing==TIMING_OFF || !(t=timing(c)))
+    return 0;
+  end=sudoku_now();
+  dur=end-start;
+  for(b=0; b<HIST_BUCKETS-1 && dur>>(b+1); ++b);
+  ++t->count[phase];
+  t->total[phase]+=dur;
+  ++t->hist[phase][b];
+  if(c->timing==TIMING_TRACE)
+    add_event(t,start,dur,phase,0);
+  return end;
+}
+
+/* Add the histograms and the events of "from" (thread tid) to "to"*/
+void sudoku_timing_add(sudoku_ctx *to,sudoku_ctx *from,int tid){
+  struct sudoku_timing *t,*f=from->times;
+  int p,b,i;
+
+  if(!f || !(t=timing(to)))
+    return;
+  for(p=0; p<N_PHASES; ++p){
+    t->count[p]+=f->count[p];
+    t->total[p]+=f->total[p];
+    for(b=0; b<HIST_BUCKETS; ++b)
+      t->hist[p][b]+=f->hist[p][b];
+  }
+  for(i=0; i<f->n_events; ++i)
+    add_event(t,f->events[i].start,f->events[i].dur,f->events[i].phase,tid);
+  t->dropped+=f->dropped;
+}
+
+/* Upper bound of the bucket holding the fraction q of a histogram (ns)*/
+static long long quantile(long *hist,long count,double q){
+  long n=0;
+  int b;
+  for(b=0; b<HIST_BUCKETS; ++b)
+    if((n+=hist[b])>=q*count)
+      break;
+  return 2LL<<b;
+}
+
+/* Print count, total, mean, median and p99 of every phase and the histograms*/
+void sudoku_print_timing(sudoku_ctx *c,FILE *fp){
+  struct sudoku_timing *t=c->times;
+  int p,b;
+
+  if(!t)
+    return;
+  fprintf(fp,"Phases (ns, median/p99 are bucket upper bounds):\n");
+  fprintf(fp,"  %-8s %10s %14s %12s %12s %12s\n","phase","count","total","mean","median","p99");
+  for(p=0; p<N_PHASES; ++p){
+    if(!t->count[p])
+      continue;
+    fprintf(fp,"  %-8s %10ld %14lld %12lld %12lld %12lld\n",phase_name[p],t->count[p],
+	    t->total[p],t->total[p]/t->count[p],quantile(t->hist[p],t->count[p],0.5),
+	    quantile(t->hist[p],t->count[p],0.99));
+  }
+  for(p=0; p<N_PHASES; ++p){
+    if(!t->count[p])
+      continue;
+    fprintf(fp,"  %s:",phase_name[p]);
+    for(b=0; b<HIST_BUCKETS; ++b)
+      if(t->hist[p][b])
+	fprintf(fp," <%lld:%ld",2LL<<b,t->hist[p][b]);
+    fprintf(fp,"\n");
+  }
+  if(t->dropped)
+    fprintf(fp,"  %ld events dropped from the trace\n",t->dropped);
+}
+
+/* Write the events in the Chrome trace event format, return 0 on failure*/
+int sudoku_write_trace(sudoku_ctx *c,const char *path){
+  struct sudoku_timing *t=c->times;
+  FILE *fp;
+  int i;
+
+  if(!(fp=fopen(path,"w")))
+    return 0;
+  fprintf(fp,"{\"traceEvents\":[\n");
+  for(i=0; t && i<t->n_events; ++i)
+    fprintf(fp,"{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+	    phase_name[t->events[i].phase],t->events[i].tid,t->events[i].start/1e3,
+	    t->events[i].dur/1e3,i+1<t->n_events ? "," : "");
+  fprintf(fp,"]}\n");
+  return !fclose(fp);
+}
+
+void sudoku_timing_free(sudoku_ctx *c){
+  if(!c->times)
+    return;
+  free(c->times->events);
+  free(c->times);
+  c->times=NULL;
+}
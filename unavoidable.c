@@ -0,0 +1,148 @@
+/*Project: Sudoku Creator
+  Description: Unavoidable sets of a solution.
+  An unavoidable set is a set of grids whose numbers can be permuted
+  into another solution. A puzzle whose solution is unique keeps at least
+  one number of every unavoidable set, so a puzzle emptying a whole set
+  is rejected with a bit test instead of a search.
+  Sets are found by emptying every grid of 2 or 3 values of the solution
+  and finding the other solutions: the grids where another solution
+  differs make an unavoidable set.*/
+
+#include<stdlib.h>
+#include<string.h>
+#include"sudoku.h"
+
+#define MAX_SETS 256     // sets kept
+#define MAX_OTHERS 64    // other solutions considered for a set of values
+
+struct sudoku_sets{
+  sudoku_mask set[MAX_SETS];
+  int n_sets;
+  int (*known)[SIZE];    // solution of the sets being found
+};
+
+/* Number of grids of a set*/
+static int size(const unsigned long long *s){
+  int i,n=0;
+  for(i=0; i<MASK_WORDS; ++i)
+    n+=__builtin_popcountll(s[i]);
+  return n;
+}
+
+/* Every grid of s is in t*/
+static int subset(const unsigned long long *s,const unsigned long long *t){
+  int i;
+  for(i=0; i<MASK_WORDS; ++i)
+    if(s[i]&~t[i])
+      return 0;
+  return 1;
+}
+
+/* Add set s, unless a set of it is already there*/
+// Sets are kept sorted by size: the small ones reject most puzzles.
+static void add_set(struct sudoku_sets *u,const unsigned long long *s){
+  int i,j,n=size(s);
+
+  for(i=0; i<u->n_sets && size(u->set[i])<=n; ++i)
+    if(subset(u->set[i],s))
+      return;
+  /* remove the sets s is a subset of*/
+  for(j=i; j<u->n_sets; ++j){
+    if(subset(s,u->set[j])){
+      memmove(u->set[j],u->set[j+1],(u->n_sets-j-1)*sizeof(sudoku_mask));
+      --u->n_sets;
+      --j;
+    }
+  }
+  if(u->n_sets==MAX_SETS){
+    if(i==MAX_SETS)
+      return;
+    --u->n_sets;   // forget the biggest one
+  }
+  memmove(u->set[i+1],u->set[i],(u->n_sets-i)*sizeof(sudoku_mask));
+  memcpy(u->set[i],s,sizeof(sudoku_mask));
+  ++u->n_sets;
+}
+
+/* Another solution is found: grids where it differs make a set*/
+static void other_solution(sudoku_ctx *t){
+  struct sudoku_sets *u=t->user;
+  int table[SIZE][SIZE];
+  sudoku_mask s={0};
+  int k;
+
+  sudoku_solution(t,table);
+  for(k=0; k<SIZE*SIZE; ++k)
+    if(table[k/SIZE][k%SIZE]!=u->known[k/SIZE][k%SIZE])
+      s[k/64]|=1ull<<k%64;
+  if(size(s))
+    add_set(u,s);
+}
+
+/* Empty the grids of values "values" and collect the other solutions*/
+static void find_sets(sudoku_ctx *t,struct sudoku_sets *u,unsigned int values){
+  int k,val;
+  for(k=0; k<SIZE*SIZE; ++k){
+    val=u->known[k/SIZE][k%SIZE];
+    t->sudoku[k/SIZE][k%SIZE]=values>>val&1 ? EMPTY : val;
+  }
+  sudoku_solve(t);
+}
+
+/* Find unavoidable sets of the solution c->known*/
+// Return the number of sets found (0 if out of memory).
+int sudoku_unavoidable(sudoku_ctx *c){
+  struct sudoku_sets *u=c->sets;
+  sudoku_ctx *t;
+  int a,b,d;
+
+  if(!u && !(u=c->sets=malloc(sizeof(struct sudoku_sets))))
+    return 0;
+  u->n_sets=0;
+  u->known=c->known;
+  if(!(t=sudoku_new()))
+    return 0;
+  t->search_order=ORDER_MRV;
+  t->max_ans=MAX_OTHERS;
+  t->solution_found=other_solution;
+  t->user=u;
+  for(a=0; a<SIZE; ++a)
+    for(b=a+1; b<SIZE; ++b){
+      find_sets(t,u,1u<<a|1u<<b);
+      for(d=b+1; d<SIZE; ++d)
+	find_sets(t,u,1u<<a|1u<<b|1u<<d);
+    }
+  sudoku_delete(t);
+  return u->n_sets;
+}
+
+/* Grids of a table that are not empty*/
+void sudoku_mask_of(int table[][SIZE],sudoku_mask m){
+  int k;
+  memset(m,0,sizeof(sudoku_mask));
+  for(k=0; k<SIZE*SIZE; ++k)
+    if(table[k/SIZE][k%SIZE]!=EMPTY)
+      m[k/64]|=1ull<<k%64;
+}
+
+/* A puzzle with given grids "given" keeps a number of every unavoidable set found*/
+// Return 1 when no set is known.
+int sudoku_covers(sudoku_ctx *c,const sudoku_mask given){
+  struct sudoku_sets *u=c->sets;
+  int i,j;
+
+  if(!u)
+    return 1;
+  for(i=0; i<u->n_sets; ++i){
+    for(j=0; j<MASK_WORDS && !(u->set[i][j]&given[j]); ++j);
+    if(j==MASK_WORDS)
+      return 0;   // the whole set is empty
+  }
+  return 1;
+}
+
+/* Release the sets*/
+void sudoku_unavoidable_free(sudoku_ctx *c){
+  free(c->sets);
+  c->sets=NULL;
+}